@@ -145,6 +145,20 @@ uint32_t File::size() {
   return _file->fileSize();
 }
 
+bool File::contiguousRange(uint32_t &bgnBlock, uint32_t &endBlock) {
+  if (! _file) {
+    return false;
+  }
+  return _file->contiguousRange(&bgnBlock, &endBlock);
+}
+
+bool File::truncate(uint32_t size) {
+  if (! _file) {
+    return false;
+  }
+  return _file->truncate(size);
+}
+
 void File::close() {
   if (_file) {
     _file->close();
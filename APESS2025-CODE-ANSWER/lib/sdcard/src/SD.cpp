@@ -578,6 +578,50 @@ namespace SDLib {
     return walkPath(filepath, root, callback_rmdir);
   }
 
+  File SDClass::createContiguous(const char *filepath, uint32_t size) {
+    int pathidx = 0;
+    SdFile parentdir = getParentDir(filepath, &pathidx);
+    filepath += pathidx;
+
+    if (!filepath[0] || !parentdir.isOpen()) {
+      return File();
+    }
+
+    SdFile file;
+    if (!file.createContiguous(&parentdir, filepath, size)) {
+      return File();
+    }
+    parentdir.close();
+
+    // Raw block writes bypass the cache, so it must not hold a block of the file
+    SdVolume::cacheClear();
+    return File(file, filepath);
+  }
+
+  bool SDClass::writeBlock(uint32_t block, const uint8_t *src, bool blocking) {
+    return card.writeBlock(block, src, blocking);
+  }
+
+  bool SDClass::isBusy() {
+    return card.isBusy();
+  }
+
+  bool SDClass::readBlock(uint32_t block, uint8_t *dst) {
+    return card.readBlock(block, dst);
+  }
+
+  uint32_t SDClass::freeBlocks() {
+    return volume.freeClusterCount() * volume.blocksPerCluster();
+  }
+
+  bool SDClass::writeStart(uint32_t block, uint32_t eraseCount) {
+    return card.writeStart(block, eraseCount);
+  }
+
+  bool SDClass::writeStop() {
+    return card.writeStreaming() ? card.writeStop() : true;
+  }
+
   bool SDClass::remove(const char *filepath) {
     return walkPath(filepath, root, callback_remove);
   }
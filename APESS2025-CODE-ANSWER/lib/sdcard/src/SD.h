@@ -44,6 +44,8 @@ namespace SDLib {
       bool seek(uint32_t pos);
       uint32_t position();
       uint32_t size();
+      bool contiguousRange(uint32_t &bgnBlock, uint32_t &endBlock);
+      bool truncate(uint32_t size);
       void close();
       operator bool();
       char * name();
@@ -95,6 +97,31 @@ namespace SDLib {
         return mkdir(filepath.c_str());
       }
 
+      // Create a new file of `size` bytes in consecutive clusters, opened for
+      // read and write. Fails if the file already exists.
+      File createContiguous(const char *filepath, uint32_t size);
+
+      // Write one 512-byte block directly to the card, e.g. inside the range
+      // of a contiguous file. The volume cache is not updated. Without
+      // `blocking` the call returns once the card accepted the data; poll
+      // isBusy() for the end of programming.
+      bool writeBlock(uint32_t block, const uint8_t *src, bool blocking = true);
+      bool isBusy();
+
+      // Read one 512-byte block directly from the card, bypassing the volume
+      // cache; the counterpart of writeBlock() for raw-written ranges.
+      bool readBlock(uint32_t block, uint8_t *dst);
+
+      // Free 512-byte blocks on the volume. Reads the whole FAT, which takes
+      // seconds on a large card.
+      uint32_t freeBlocks();
+
+      // Open a multiple block write at `block`, pre-erasing `eraseCount`
+      // blocks that belong to the caller. Consecutive non-blocking writeBlock()
+      // calls then stream into it; writeStop() or any other card access ends it.
+      bool writeStart(uint32_t block, uint32_t eraseCount);
+      bool writeStop();
+
       // Delete the file.
       bool remove(const char *filepath);
       bool remove(const String &filepath) {
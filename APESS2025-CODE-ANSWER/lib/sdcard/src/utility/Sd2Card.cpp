@@ -114,6 +114,11 @@ uint8_t Sd2Card::cardCommand(uint8_t cmd, uint32_t arg) {
   // end read if in partialBlockRead mode
   readEnd();
 
+  // end a multiple block write, every other command needs the card in transfer state
+  if (writeStream_) {
+    writeStop();
+  }
+
   // select card
   chipSelectLow();
 
@@ -256,6 +261,8 @@ uint8_t Sd2Card::eraseSingleBlockEnable(void) {
 */
 uint8_t Sd2Card::init(uint8_t sckRateID, uint8_t chipSelectPin) {
   errorCode_ = inBlock_ = partialBlockRead_ = type_ = 0;
+  writeStream_ = 0;
+  lastWrite_ = 0XFFFFFFFF;
   chipSelectPin_ = chipSelectPin;
   // 16-bit init start time allows over a minute
   unsigned int t0 = millis();
@@ -608,7 +615,9 @@ fail:
 
    \param[in] blockNumber Logical block to be written.
    \param[in] src Pointer to the location of the data to be written.
-   \param[in] blocking If the write should be blocking.
+   \param[in] blocking If the write should be blocking. Only non-blocking
+   writes of consecutive blocks are combined into a multiple block write; a
+   blocking one ends it and returns after the card confirmed programming.
    \return The value one, true, is returned for success and
    the value zero, false, is returned for failure.
 */
@@ -621,6 +630,24 @@ uint8_t Sd2Card::writeBlock(uint32_t blockNumber, const uint8_t* src, uint8_t bl
   }
   #endif  // SD_PROTECT_BLOCK_ZERO
 
+  if (!blocking) {
+    // sequential writes go through one multiple block write: continue an open
+    // sequence, or open one on the second of two consecutive blocks
+    if (writeStream_ && blockNumber == writeNext_) {
+      return writeData(src);
+    }
+    if (!writeStream_ && lastWrite_ != 0XFFFFFFFF && blockNumber == lastWrite_ + 1) {
+      if (writeStart(blockNumber, 0)) {
+        return writeData(src);
+      }
+    }
+  } else if (writeStream_ && !writeStop()) {
+    // a blocking write reports the programming status, so the blocks
+    // streamed before it must be programmed too
+    goto fail;
+  }
+  lastWrite_ = blockNumber;
+
   // use address if not SDHC card
   if (type() != SD_CARD_TYPE_SDHC) {
     blockNumber <<= 9;
@@ -654,13 +681,21 @@ fail:
 //------------------------------------------------------------------------------
 /** Write one data block in a multiple block write sequence */
 uint8_t Sd2Card::writeData(const uint8_t* src) {
+  chipSelectLow();
   // wait for previous write to finish
   if (!waitNotBusy(SD_WRITE_TIMEOUT)) {
     error(SD_CARD_ERROR_WRITE_MULTIPLE);
     chipSelectHigh();
     return false;
   }
-  return writeData(WRITE_MULTIPLE_TOKEN, src);
+  if (!writeData(WRITE_MULTIPLE_TOKEN, src)) {
+    return false;
+  }
+  lastWrite_ = writeNext_++;
+  // the card stays in the sequence with chip select high, so the bus is free
+  // for other devices (the radio) between blocks
+  chipSelectHigh();
+  return true;
 }
 //------------------------------------------------------------------------------
 // send one block of data for write block or write multiple blocks
@@ -705,10 +740,13 @@ uint8_t Sd2Card::writeData(uint8_t token, const uint8_t* src) {
 /** Start a write multiple blocks sequence.
 
    \param[in] blockNumber Address of first block in sequence.
-   \param[in] eraseCount The number of blocks to be pre-erased.
+   \param[in] eraseCount The number of blocks to be pre-erased (ACMD23),
+   zero to skip the hint. Pre-erased blocks that are not written are
+   undefined, so only hint blocks the caller owns.
 
    \note This function is used with writeData() and writeStop()
-   for optimized multiple block writes.
+   for optimized multiple block writes. Non-blocking writeBlock() calls
+   continue the sequence for consecutive blocks, any other command ends it.
 
    \return The value one, true, is returned for success and
    the value zero, false, is returned for failure.
@@ -722,10 +760,11 @@ uint8_t Sd2Card::writeStart(uint32_t blockNumber, uint32_t eraseCount) {
   }
   #endif  // SD_PROTECT_BLOCK_ZERO
   // send pre-erase count
-  if (cardAcmd(ACMD23, eraseCount)) {
+  if (eraseCount && cardAcmd(ACMD23, eraseCount)) {
     error(SD_CARD_ERROR_ACMD23);
     goto fail;
   }
+  writeNext_ = blockNumber;
   // use address if not SDHC card
   if (type() != SD_CARD_TYPE_SDHC) {
     blockNumber <<= 9;
@@ -734,6 +773,8 @@ uint8_t Sd2Card::writeStart(uint32_t blockNumber, uint32_t eraseCount) {
     error(SD_CARD_ERROR_CMD25);
     goto fail;
   }
+  writeStream_ = 1;
+  chipSelectHigh();
   return true;
 
 fail:
@@ -747,6 +788,8 @@ fail:
    the value zero, false, is returned for failure.
 */
 uint8_t Sd2Card::writeStop(void) {
+  writeStream_ = 0;
+  chipSelectLow();
   if (!waitNotBusy(SD_WRITE_TIMEOUT)) {
     goto fail;
   }
@@ -754,6 +797,12 @@ uint8_t Sd2Card::writeStop(void) {
   if (!waitNotBusy(SD_WRITE_TIMEOUT)) {
     goto fail;
   }
+  // response is r2 so get and check two bytes for nonzero
+  if (cardCommand(CMD13, 0) || spiRec()) {
+    error(SD_CARD_ERROR_WRITE_PROGRAMMING);
+    chipSelectHigh();
+    return false;
+  }
   chipSelectHigh();
   return true;
 
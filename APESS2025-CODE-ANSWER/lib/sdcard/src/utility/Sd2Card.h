@@ -176,7 +176,8 @@ uint8_t const SD_CARD_TYPE_SDHC = 3;
 class Sd2Card {
   public:
     /** Construct an instance of Sd2Card. */
-    Sd2Card(void) : errorCode_(0), inBlock_(0), partialBlockRead_(0), type_(0) {}
+    Sd2Card(void) : errorCode_(0), inBlock_(0), partialBlockRead_(0), type_(0),
+      writeStream_(0), writeNext_(0), lastWrite_(0XFFFFFFFF) {}
     uint32_t cardSize(void);
     uint8_t erase(uint32_t firstBlock, uint32_t lastBlock);
     uint8_t eraseSingleBlockEnable(void);
@@ -240,6 +241,10 @@ class Sd2Card {
     uint8_t writeData(const uint8_t* src);
     uint8_t writeStart(uint32_t blockNumber, uint32_t eraseCount);
     uint8_t writeStop(void);
+    /** \return true while a multiple block write (CMD25) is open. */
+    uint8_t writeStreaming(void) const {
+      return writeStream_;
+    }
     uint8_t isBusy(void);
   private:
     uint32_t block_;
@@ -250,6 +255,9 @@ class Sd2Card {
     uint8_t partialBlockRead_;
     uint8_t status_;
     uint8_t type_;
+    uint8_t writeStream_;   // CMD25 sequence open, ended by the next other command
+    uint32_t writeNext_;    // Block number the open sequence writes next
+    uint32_t lastWrite_;    // Last block written, 0XFFFFFFFF if none
     // private functions
     uint8_t cardAcmd(uint8_t cmd, uint32_t arg) {
       cardCommand(CMD55, 0);
@@ -17,7 +17,7 @@
    along with the Arduino SdFat Library.  If not, see
    <http://www.gnu.org/licenses/>.
 */
-#if defined(__arm__) // Arduino Due Board follows
+#if defined(__arm__) || defined(SD_HOST_SIM) // Arduino Due Board and host simulator follow
 
 #ifndef Sd2PinMap_h
   #define Sd2PinMap_h
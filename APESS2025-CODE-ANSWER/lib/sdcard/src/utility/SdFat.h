@@ -520,6 +520,8 @@ class SdVolume {
     uint32_t clusterCount(void) const {
       return clusterCount_;
     }
+    /** \return The number of free clusters, counted by reading the whole FAT. */
+    uint32_t freeClusterCount(void) const;
     /** \return The shift count required to multiply by blocksPerCluster. */
     uint8_t clusterSizeShift(void) const {
       return clusterSizeShift_;
@@ -631,6 +633,9 @@ class SdVolume {
     uint8_t writeBlock(uint32_t block, const uint8_t* dst, uint8_t blocking = 1) {
       return sdCard_->writeBlock(block, dst, blocking);
     }
+    uint8_t writeStop(void) {
+      return sdCard_->writeStreaming() ? sdCard_->writeStop() : true;
+    }
     uint8_t isBusy(void) {
       return sdCard_->isBusy();
     }
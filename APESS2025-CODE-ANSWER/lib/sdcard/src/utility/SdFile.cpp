@@ -1135,6 +1135,12 @@ uint8_t SdFile::sync(uint8_t blocking) {
     return false;
   }
 
+  // end an open multiple block write before any other command ends it
+  // without reporting the programming status
+  if (blocking && !vol_->writeStop()) {
+    return false;
+  }
+
   if (flags_ & F_FILE_DIR_DIRTY) {
     dir_t* d = cacheDirEntry(SdVolume::CACHE_FOR_WRITE);
     if (!d) {
@@ -1333,8 +1339,6 @@ size_t SdFile::write(const void* buf, uint16_t nbyte) {
 
   // number of bytes left to write  -  must be before goto statements
   uint16_t nToWrite = nbyte;
-  // if blocking writes should be used
-  uint8_t blocking = (flags_ & F_FILE_NON_BLOCKING_WRITE) == 0x00;
 
   // error if not a normal file or is read-only
   if (!isFile() || !(flags_ & O_WRITE)) {
@@ -1393,14 +1397,19 @@ size_t SdFile::write(const void* buf, uint16_t nbyte) {
       if (SdVolume::cacheBlockNumber_ == block) {
         SdVolume::cacheBlockNumber_ = 0XFFFFFFFF;
       }
-      if (!vol_->writeBlock(block, src, blocking)) {
+      // non-blocking so sequential appends stream through one multiple
+      // block write, sync() ends the stream and checks the programming
+      if (!vol_->writeBlock(block, src, 0)) {
         goto writeErrorReturn;
       }
       src += 512;
     } else {
       if (blockOffset == 0 && curPosition_ >= fileSize_) {
-        // start of new block don't need to read into cache
-        if (!SdVolume::cacheFlush()) {
+        // start of new block don't need to read into cache, a cached
+        // previous data block is flushed non-blocking so appends stream
+        uint8_t blocking = SdVolume::cacheBlockNumber_ + 1 != block ||
+                           SdVolume::cacheMirrorBlock_ != 0;
+        if (!SdVolume::cacheFlush(blocking)) {
           goto writeErrorReturn;
         }
         SdVolume::cacheBlockNumber_ = block;
@@ -199,6 +199,21 @@ uint8_t SdVolume::fatGet(uint32_t cluster, uint32_t* value) const {
   return true;
 }
 //------------------------------------------------------------------------------
+// count free clusters, one cache fill per FAT block
+uint32_t SdVolume::freeClusterCount(void) const {
+  uint32_t count = 0;
+  for (uint32_t cluster = 2; cluster < clusterCount_ + 2; cluster++) {
+    uint32_t f;
+    if (!fatGet(cluster, &f)) {
+      return 0;
+    }
+    if (f == 0) {
+      count++;
+    }
+  }
+  return count;
+}
+//------------------------------------------------------------------------------
 // Store a FAT entry
 uint8_t SdVolume::fatPut(uint32_t cluster, uint32_t value) {
   // error if reserved cluster
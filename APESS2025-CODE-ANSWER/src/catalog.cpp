@@ -0,0 +1,201 @@
+#include <Arduino.h>
+#include <stddef.h>
+#include "catalog.hpp"
+#include "crc32.hpp"
+#include "sdcard.hpp"
+#include "sample_format.hpp"
+#include "sample_codec.hpp"
+#include "time.hpp"
+#include "mqtt.hpp"
+
+static uint32_t catalog_entry_crc(const CatalogEntry &entry)
+{
+    return crc32(&entry, offsetof(CatalogEntry, crc));
+}
+
+static bool catalog_entry_valid(const CatalogEntry &entry)
+{
+    return entry.magic == CATALOG_ENTRY_MAGIC && entry.crc == catalog_entry_crc(entry);
+}
+
+bool catalog_append(CatalogEntry &entry)
+{
+    entry.magic = CATALOG_ENTRY_MAGIC;
+    entry.reserved = 0;
+    entry.crc = catalog_entry_crc(entry);
+
+    File file = SD.open(CATALOG_FILE, O_RDWR | O_CREAT);
+    if (!file)
+    {
+        Serial.println("[SD] Catalog unavailable.");
+        return false;
+    }
+
+    // Only the last entry can be torn; it is overwritten, as is an older entry of the same log
+    uint32_t pos = file.size() - file.size() % sizeof(CatalogEntry);
+    if (pos >= sizeof(CatalogEntry))
+    {
+        CatalogEntry last;
+        file.seek(pos - sizeof(last));
+        if (file.read(&last, sizeof(last)) != sizeof(last) || !catalog_entry_valid(last) ||
+            last.log_number == entry.log_number)
+            pos -= sizeof(last);
+    }
+
+    bool ok = file.seek(pos) && file.write(reinterpret_cast<const uint8_t *>(&entry), sizeof(entry)) == sizeof(entry);
+    file.close();
+    if (!ok)
+        Serial.println("[SD] Catalog write failed.");
+    return ok;
+}
+
+bool catalog_find(uint16_t log_number, CatalogEntry &entry)
+{
+    File file = SD.open(CATALOG_FILE, FILE_READ);
+    if (!file)
+        return false;
+
+    bool found = false;
+    CatalogEntry candidate;
+    while (file.read(&candidate, sizeof(candidate)) == sizeof(candidate))
+    {
+        if (catalog_entry_valid(candidate) && candidate.log_number == log_number)
+        {
+            entry = candidate;
+            found = true;
+        }
+    }
+    file.close();
+    return found;
+}
+
+uint16_t catalog_query(uint64_t from_ms, uint64_t to_ms, void (*fn)(const CatalogEntry &entry))
+{
+    File file = SD.open(CATALOG_FILE, FILE_READ);
+    if (!file)
+        return 0;
+
+    uint16_t matches = 0;
+    CatalogEntry entry;
+    while (file.read(&entry, sizeof(entry)) == sizeof(entry))
+    {
+        if (!catalog_entry_valid(entry) || entry.start_ms < from_ms || entry.start_ms >= to_ms)
+            continue;
+        if (fn)
+            fn(entry);
+        matches++;
+    }
+    file.close();
+    return matches;
+}
+
+bool catalog_scan_file(const char *name, CatalogEntry &entry)
+{
+    File file = SD.open(name, FILE_READ);
+    if (!file)
+        return false;
+
+    uint8_t block[SAMPLE_BLOCK_SIZE];
+    int len = file.read(block, sizeof(block));
+    const SampleFileHeader *header = reinterpret_cast<const SampleFileHeader *>(block);
+    if (len != SAMPLE_BLOCK_SIZE || header->magic != SAMPLE_FILE_MAGIC || header->version != SAMPLE_FILE_VERSION)
+    {
+        file.close();
+        return false;
+    }
+
+    memset(&entry, 0, sizeof(entry));
+    entry.log_number = header->log_number;
+    entry.node_id = header->node_id;
+    entry.start_ms = header->start_ms;
+    entry.rate_hz = header->rate_hz;
+    entry.duration_s = header->duration_s;
+    entry.codec = header->codec;
+    entry.flags = header->flags;
+    entry.bytes = file.size();
+
+    // Record counts from the block headers, CRC over every byte
+    uint32_t crc = crc32_update(CRC32_INIT, block, len);
+    while ((len = file.read(block, sizeof(block))) > 0)
+    {
+        crc = crc32_update(crc, block, len);
+
+        const SampleBlockHeader *raw = reinterpret_cast<const SampleBlockHeader *>(block);
+        // Coded blocks start with the same magic / count / t0_ms fields
+        if (len == SAMPLE_BLOCK_SIZE && (raw->magic == SAMPLE_BLOCK_MAGIC || raw->magic == SAMPLE_CODED_MAGIC))
+            entry.samples += raw->count;
+    }
+    entry.file_crc = crc32_final(crc);
+
+    file.close();
+    return true;
+}
+
+void catalog_init()
+{
+    if (SD.exists(CATALOG_FILE))
+        return;
+
+    Serial.println("[SD] No catalog, indexing sample logs...");
+
+    // Created first, so a card without logs is not walked again at every boot
+    File catalog = SD.open(CATALOG_FILE, FILE_WRITE);
+    if (!catalog)
+    {
+        Serial.println("[SD] Catalog unavailable.");
+        return;
+    }
+    catalog.close();
+
+    File root = SD.open("/");
+    uint16_t added = 0;
+    for (File file = root.openNextFile(); file; file = root.openNextFile())
+    {
+        char name[16];
+        snprintf(name, sizeof(name), "/%s", file.name());
+        const char *ext = strrchr(name, '.');
+        bool log_file = !file.isDirectory() && ext && strcmp(ext, SAMPLE_FILE_EXT) == 0;
+        file.close();
+
+        // Other .BIN files (the catalog itself, benchmark scratch) fail the header check
+        CatalogEntry entry;
+        if (log_file && catalog_scan_file(name, entry) && catalog_append(entry))
+            added++;
+    }
+    root.close();
+
+    Serial.print("[SD] Catalog built: ");
+    Serial.print(added);
+    Serial.println(" sample logs.");
+}
+
+// One MQTT message per session
+static void catalog_publish_entry(const CatalogEntry &entry)
+{
+    CalendarTime start = calendar_from_unix_milliseconds(entry.start_ms);
+
+    char buf[160];
+    snprintf(buf, sizeof(buf), "N%03u_%03u %04u-%02u-%02u %02u:%02u:%02u | %lu Hz | %lu s | %lu samples | %lu B | %s | CRC %08lX%s",
+             entry.node_id, entry.log_number,
+             start.year, start.month, start.day, start.hour, start.minute, start.second,
+             (unsigned long)entry.rate_hz, (unsigned long)entry.duration_s,
+             (unsigned long)entry.samples, (unsigned long)entry.bytes,
+             entry.codec == SAMPLE_CODEC_RICE ? "RICE" : "RAW",
+             (unsigned long)entry.file_crc,
+             entry.flags & SAMPLE_FLAG_TRIGGERED ? " | TRIGGERED" : "");
+    mqtt_client.publish(MQTT_TOPIC_PUB, buf);
+    Serial.println(buf);
+
+    mqtt_loop(); // keep MQTT alive
+    delay(20);   // throttle
+}
+
+void catalog_publish(uint64_t from_ms, uint64_t to_ms)
+{
+    uint16_t count = catalog_query(from_ms, to_ms, catalog_publish_entry);
+
+    char buf[48];
+    snprintf(buf, sizeof(buf), "CMD_LIST: %u sessions.", count);
+    mqtt_client.publish(MQTT_TOPIC_PUB, buf);
+    Serial.println("[COMMUNICATION] CMD_LIST sent.");
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Session catalog
+ *
+ * /CATALOG.BIN holds one fixed-size CatalogEntry per completed sample log,
+ * appended when the log is closed (or recovered at boot), so listing and
+ * time-range queries read one small file instead of walking the directory
+ * and opening every log. Each entry carries its own CRC-32; a torn entry at
+ * the end is skipped and overwritten by the next append.
+ * This header only depends on <stdint.h> so host tools can read catalogs.
+ */
+
+#define CATALOG_FILE        "/CATALOG.BIN"
+#define CATALOG_ENTRY_MAGIC 0x43535041UL // "APSC"
+
+typedef struct {
+    uint32_t magic;       // CATALOG_ENTRY_MAGIC
+    uint16_t log_number;
+    uint16_t node_id;
+    uint64_t start_ms;    // Unix ms of the first record, as in SampleFileHeader
+    uint32_t rate_hz;
+    uint32_t duration_s;  // Scheduled duration
+    uint32_t samples;     // Records stored
+    uint32_t bytes;       // File size
+    uint32_t file_crc;    // CRC-32 of the whole file
+    uint16_t codec;       // SAMPLE_CODEC_*
+    uint16_t flags;       // SAMPLE_FLAG_*
+    uint32_t reserved;
+    uint32_t crc;         // CRC-32 of the fields above
+} CatalogEntry;
+
+static_assert(sizeof(CatalogEntry) == 48, "CatalogEntry must have no padding, the CRC covers every byte");
+
+// Build the catalog from the sample logs on the card if it has none (cards written before the catalog)
+void catalog_init();
+
+// Add the entry of a closed log; replaces the last entry if it is the same log
+bool catalog_append(CatalogEntry &entry);
+
+// Newest entry of a log number
+bool catalog_find(uint16_t log_number, CatalogEntry &entry);
+
+// Call fn for every entry starting in [from_ms, to_ms), in catalog order; returns the number of matches
+uint16_t catalog_query(uint64_t from_ms, uint64_t to_ms, void (*fn)(const CatalogEntry &entry));
+
+// Fill an entry by reading a sample log (header, block counts, CRC); false if it is not one
+bool catalog_scan_file(const char *name, CatalogEntry &entry);
+
+// Publish the entries starting in [from_ms, to_ms) to MQTT_TOPIC_PUB, one message each
+void catalog_publish(uint64_t from_ms, uint64_t to_ms);
@@ -8,6 +8,13 @@ uint32_t sensing_rate_hz = default_sensing_rate_hz ;
 uint32_t sensing_duration_s = default_sensing_duration_s;
 uint16_t parsed_freq = 0;
 uint16_t parsed_duration = 0;
+uint8_t default_sensing_range_g = 2;
+uint8_t sensing_range_g = default_sensing_range_g;
+uint16_t sensing_dlpf_hz = 0;
+uint8_t parsed_range_g = default_sensing_range_g;
+uint16_t parsed_dlpf_hz = 0;
+uint16_t trigger_rate_hz = 200;
+uint16_t trigger_post_s = 30;
 
 float cali_scale_x = 1.0f; // Calibration scale for X-axis
 float cali_scale_y = 1.0f; // Calibration scale for Y-axis
@@ -38,6 +38,10 @@
 #define MQTT_PASSWORD       "Arduino123"
 #define MQTT_TOPIC_PUB      "ArduinoNode/node"
 #define MQTT_TOPIC_SUB      "ArduinoNode/server"
+// #define RETRIEVAL_ACK // Keep retrieval chunks in flight until the server acknowledges them (CMD_ACK_<name>:<chunks>), resend the rest
+
+/* RF Configurations */
+// #define RF_IRQ_RECEIVE // nRF24L01 IRQ wired to RF_IRQ_PIN: received messages are queued on interrupt instead of polled
 
 // Sensing Variables 
 extern uint64_t sensing_scheduled_start_ms; // Scheduled sensing start time (Unix ms)
@@ -48,10 +52,28 @@ extern uint32_t default_sensing_rate_hz;   // Default sensing rate in Hz
 extern uint32_t default_sensing_duration_s; // Default sensing duration in seconds
 extern uint16_t parsed_freq;                // Parsed frequency from command
 extern uint16_t parsed_duration;            // Parsed duration from command
+extern uint8_t sensing_range_g;             // Accelerometer full scale in g (2, 4, 8, 16)
+extern uint16_t sensing_dlpf_hz;            // Anti-alias bandwidth in Hz, 0 = pick from the sensing rate
+extern uint8_t default_sensing_range_g;     // Default accelerometer full scale in g
+extern uint8_t parsed_range_g;              // Parsed full scale from command
+extern uint16_t parsed_dlpf_hz;             // Parsed anti-alias bandwidth from command
+extern uint16_t trigger_rate_hz;            // Monitoring rate while armed for events (SENSING_TRIGGER)
+extern uint16_t trigger_post_s;             // Recording time after an event trigger in seconds
 extern float cali_scale_x; // Calibration scale for X-axis
 extern float cali_scale_y; // Calibration scale for Y-axis
 extern float cali_scale_z; // Calibration scale for Z-axis
 
+/* Sensing Configurations */
+// #define IMU_FIFO_MODE // Let the MPU6050 FIFO pace sampling for rates dividing 1 kHz
+// #define SENSING_DECIMATION // Acquire at up to 1 kHz and FIR-decimate to the requested rate
+// #define SENSING_SPECTRUM // Write a Welch PSD / peak summary (.PSD) next to each sample log
+// #define IMU_DRDY_INTERRUPT // With IMU_FIFO_MODE: MPU6050 INT wired to D2, timestamps from data-ready edges
+// #define SAMPLE_COMPRESSION // Store delta / Rice coded blocks (lossless, about 3x smaller logs and retrievals)
+// #define SENSING_TRIGGER // CMD_TRIGGER_ON arms STA/LTA event recording with pre-trigger samples while IDLE
+
+/* SD Card Configurations */
+// #define SD_BENCHMARK // Benchmark the SD write paths once after SD init (throughput, p50/p99/max latency), see sd_bench.hpp
+
 /* Serial Configurations */
 // #define DATA_PRINTOUT // Enable data printout to Serial
 
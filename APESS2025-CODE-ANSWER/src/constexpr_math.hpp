@@ -0,0 +1,47 @@
+#pragma once
+
+#include <stdint.h>
+
+/*
+ * Trigonometry usable in constant expressions, for coefficient tables that are
+ * generated at compile time (FIR taps, FFT twiddles, windows).
+ */
+
+namespace ce
+{
+constexpr double PI = 3.14159265358979323846;
+
+// Reduce to [-pi, pi], then Taylor series
+constexpr double sin(double x)
+{
+    while (x > PI)
+        x -= 2.0 * PI;
+    while (x < -PI)
+        x += 2.0 * PI;
+
+    double term = x;
+    double sum = x;
+    for (int n = 1; n < 12; ++n)
+    {
+        term *= -x * x / ((2 * n) * (2 * n + 1));
+        sum += term;
+    }
+    return sum;
+}
+
+constexpr double cos(double x)
+{
+    return sin(x + PI / 2.0);
+}
+
+// Round to the nearest Q15 value, saturating at +1
+constexpr int16_t q15(double x)
+{
+    double q = x * 32768.0;
+    if (q >= 32767.0)
+        return 32767;
+    if (q <= -32768.0)
+        return -32768;
+    return (int16_t)(q < 0 ? q - 0.5 : q + 0.5);
+}
+} // namespace ce
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * CRC-32 (IEEE 802.3, reflected, as zlib / PNG), nibble-table implementation:
+ * 64 bytes of table instead of 1 KB, about twice the cost per byte.
+ * Depends only on <stdint.h> so host tools can use it too.
+ */
+
+#define CRC32_INIT 0xFFFFFFFFUL
+
+// Continue a running CRC; start from CRC32_INIT and finish with crc32_final()
+uint32_t crc32_update(uint32_t crc, const void *data, size_t len);
+
+inline uint32_t crc32_final(uint32_t crc)
+{
+    return crc ^ 0xFFFFFFFFUL;
+}
+
+inline uint32_t crc32(const void *data, size_t len)
+{
+    return crc32_final(crc32_update(CRC32_INIT, data, len));
+}
@@ -0,0 +1,160 @@
+#include "decimator.hpp"
+#include "constexpr_math.hpp"
+
+/* === Compile-time coefficient generation === */
+
+namespace
+{
+template <uint8_t FACTOR>
+struct FirTable
+{
+    static constexpr uint16_t TAPS = DECIMATOR_TAPS_PER_FACTOR * FACTOR + 1;
+    int16_t h[TAPS];
+
+    constexpr FirTable() : h()
+    {
+        const double fc = 0.4 / FACTOR; // Cutoff in cycles per input sample
+        const int mid = (TAPS - 1) / 2;
+
+        double ideal[TAPS] = {};
+        double sum = 0.0;
+        for (int i = 0; i < TAPS; ++i)
+        {
+            int k = i - mid;
+            double sinc = k == 0 ? 2.0 * fc : ce::sin(2.0 * ce::PI * fc * k) / (ce::PI * k);
+            double window = 0.54 - 0.46 * ce::cos(2.0 * ce::PI * i / (TAPS - 1));
+            ideal[i] = sinc * window;
+            sum += ideal[i];
+        }
+
+        // Quantise to Q15 with unity DC gain; the centre tap absorbs the rounding error
+        int32_t total = 0;
+        for (int i = 0; i < TAPS; ++i)
+        {
+            double q = ideal[i] / sum * 32768.0;
+            h[i] = (int16_t)(q < 0 ? q - 0.5 : q + 0.5);
+            total += h[i];
+        }
+        h[mid] = (int16_t)(h[mid] + (32768 - total));
+    }
+};
+
+constexpr FirTable<2> fir2;
+constexpr FirTable<4> fir4;
+constexpr FirTable<5> fir5;
+constexpr FirTable<10> fir10;
+
+static_assert(FirTable<DECIMATOR_MAX_FACTOR>::TAPS == DECIMATOR_MAX_TAPS, "DECIMATOR_MAX_TAPS out of date");
+} // namespace
+
+/* === Runtime state === */
+
+static const int16_t *coeffs = nullptr;
+static uint8_t factor = 1;
+static uint16_t taps = 1;
+static int16_t history[3][DECIMATOR_MAX_TAPS]; // Circular, head is the oldest entry
+static uint32_t stamps[DECIMATOR_MAX_TAPS];
+static uint16_t head = 0;
+static uint32_t inputs = 0;
+
+const int16_t *decimator_coefficients(uint8_t f, uint16_t &n)
+{
+    switch (f)
+    {
+    case 2:  n = fir2.TAPS;  return fir2.h;
+    case 4:  n = fir4.TAPS;  return fir4.h;
+    case 5:  n = fir5.TAPS;  return fir5.h;
+    case 10: n = fir10.TAPS; return fir10.h;
+    default: n = 0;          return nullptr;
+    }
+}
+
+bool decimator_supported(uint8_t f)
+{
+    uint16_t n;
+    return f == 1 || decimator_coefficients(f, n) != nullptr;
+}
+
+uint8_t decimator_factor_for(uint32_t output_rate_hz, uint32_t max_input_rate_hz)
+{
+    static const uint8_t factors[] = {10, 5, 4, 2};
+    for (uint8_t f : factors)
+    {
+        if (output_rate_hz * f <= max_input_rate_hz)
+            return f;
+    }
+    return 1;
+}
+
+void decimator_reset(uint8_t f)
+{
+    uint16_t n = 1;
+    coeffs = decimator_coefficients(f, n);
+    factor = coeffs ? f : 1;
+    taps = coeffs ? n : 1;
+    head = 0;
+    inputs = 0;
+}
+
+uint8_t decimator_factor()
+{
+    return factor;
+}
+
+uint16_t decimator_taps()
+{
+    return taps;
+}
+
+static int16_t decimator_dot(const int16_t *x)
+{
+    // Oldest sample meets h[0]; the window is symmetric so the direction does not matter
+    int64_t acc = 0;
+    uint16_t idx = head;
+    for (uint16_t i = 0; i < taps; ++i)
+    {
+        acc += (int32_t)coeffs[i] * x[idx];
+        if (++idx == taps)
+            idx = 0;
+    }
+
+    acc = (acc + (1 << 14)) >> 15;
+    if (acc > INT16_MAX)
+        return INT16_MAX;
+    if (acc < INT16_MIN)
+        return INT16_MIN;
+    return (int16_t)acc;
+}
+
+bool decimator_push(uint32_t elapsed_ms, int16_t ax, int16_t ay, int16_t az,
+                    uint32_t &out_ms, int16_t out_xyz[3])
+{
+    if (factor == 1)
+    {
+        out_ms = elapsed_ms;
+        out_xyz[0] = ax;
+        out_xyz[1] = ay;
+        out_xyz[2] = az;
+        return true;
+    }
+
+    // The new sample replaces the oldest entry
+    history[0][head] = ax;
+    history[1][head] = ay;
+    history[2][head] = az;
+    stamps[head] = elapsed_ms;
+    if (++head == taps)
+        head = 0;
+    inputs++;
+
+    // Window full, and its centre falls on the output grid
+    uint16_t delay = (taps - 1) / 2;
+    if (inputs < taps || (inputs - 1 - delay) % factor != 0)
+        return false;
+
+    out_ms = stamps[(head + delay) % taps];
+    out_xyz[0] = decimator_dot(history[0]);
+    out_xyz[1] = decimator_dot(history[1]);
+    out_xyz[2] = decimator_dot(history[2]);
+    return true;
+}
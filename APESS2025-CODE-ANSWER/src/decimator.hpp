@@ -0,0 +1,37 @@
+#pragma once
+
+#include <stdint.h>
+
+/*
+ * Decimator - fixed-point FIR anti-alias filter and down-sampler.
+ *
+ * Samples are acquired at factor * output rate and low-pass filtered by a
+ * Hamming-windowed sinc FIR in Q15 (cutoff at 0.8 x the output Nyquist
+ * frequency, unity DC gain). Only every factor-th output is computed, which
+ * is the polyphase form of FIR decimation. Coefficient tables are generated at
+ * compile time (see decimator.cpp).
+ *
+ * The filter is linear phase with a delay of (taps - 1) / 2 = 5 * factor
+ * input samples, so each output carries the timestamp of the input at the
+ * centre of its window. Outputs start once the window is full and land on the
+ * output rate grid relative to the first input.
+ *
+ * This file only depends on <stdint.h> so it also builds on a host.
+ */
+
+#define DECIMATOR_TAPS_PER_FACTOR 10 // Taps = 10 * factor + 1
+#define DECIMATOR_MAX_FACTOR 10
+#define DECIMATOR_MAX_TAPS (DECIMATOR_TAPS_PER_FACTOR * DECIMATOR_MAX_FACTOR + 1)
+
+bool decimator_supported(uint8_t factor);          // 1 (pass-through), 2, 4, 5 or 10
+uint8_t decimator_factor_for(uint32_t output_rate_hz, uint32_t max_input_rate_hz);
+void decimator_reset(uint8_t factor);
+uint8_t decimator_factor();
+uint16_t decimator_taps();
+
+// Feed one input sample; returns true and fills out_ms / out_xyz when an output is ready
+bool decimator_push(uint32_t elapsed_ms, int16_t ax, int16_t ay, int16_t az,
+                    uint32_t &out_ms, int16_t out_xyz[3]);
+
+// Coefficients of a factor, nullptr if unsupported (for inspection and host checks)
+const int16_t *decimator_coefficients(uint8_t factor, uint16_t &taps);
@@ -0,0 +1,67 @@
+#include "imu_timing.hpp"
+
+static uint32_t start_us = 0;
+static uint32_t start_ms = 0;
+static float drift = 1.0f;
+static uint32_t first_us = 0;
+static uint32_t edge_count = 0;
+static double period_us = 0.0;
+static ImuTimingStats stats;
+
+void imu_timing_reset(uint32_t start_local_us, uint32_t start_elapsed_ms, float drift_ratio, uint32_t nominal_rate_hz)
+{
+    start_us = start_local_us;
+    start_ms = start_elapsed_ms;
+    drift = drift_ratio;
+    first_us = 0;
+    edge_count = 0;
+    period_us = nominal_rate_hz ? 1e6 / nominal_rate_hz : 0.0; // Until two edges have been seen
+
+    stats.batches = 0;
+    stats.period_us = period_us;
+    stats.last_residual_us = 0;
+    stats.max_residual_us = 0;
+}
+
+void imu_timing_update(uint32_t edges, uint32_t first_edge_us, uint64_t last_since_first_us)
+{
+    if (edges == 0 || edges == edge_count)
+        return;
+
+    first_us = first_edge_us;
+
+    if (edge_count > 0)
+    {
+        double predicted_us = (edges - 1) * period_us;
+        int32_t residual = (int32_t)((double)last_since_first_us - predicted_us);
+        int32_t magnitude = residual < 0 ? -residual : residual;
+
+        stats.last_residual_us = residual;
+        if (magnitude > stats.max_residual_us)
+            stats.max_residual_us = magnitude;
+    }
+
+    if (edges >= 2)
+        period_us = (double)last_since_first_us / (edges - 1);
+
+    edge_count = edges;
+    stats.batches++;
+    stats.period_us = period_us;
+}
+
+bool imu_timing_ready()
+{
+    return edge_count > 0;
+}
+
+uint32_t imu_timing_elapsed_ms(uint32_t edge)
+{
+    // Local time of the sample relative to the start, then scaled to unified time
+    double local_us = (double)(int32_t)(first_us - start_us) + edge * period_us;
+    return start_ms + (int32_t)(local_us * drift / 1000.0 + 0.5);
+}
+
+const ImuTimingStats &imu_timing_stats()
+{
+    return stats;
+}
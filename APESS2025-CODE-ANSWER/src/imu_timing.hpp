@@ -0,0 +1,35 @@
+#pragma once
+
+#include <stdint.h>
+
+/*
+ * IMU timing reconstruction from data-ready edges
+ *
+ * Every MPU6050 data-ready edge marks one new sample on the sensor clock. The
+ * ISR stamps the edges with micros(); per batch, the loop feeds the latest edge
+ * into this model, which fits the sensor period from the first and latest
+ * edge: T = (t_last - t_first) / (edges - 1). Sample e (0-based) is then
+ * placed at t_first + e * T, so edge jitter averages out over the session
+ * instead of reaching individual timestamps. Local times are converted to
+ * unified network time with the sync drift ratio.
+ *
+ * The residual of a batch is the measured time of its latest edge minus the
+ * time predicted by the fit of the previous batch.
+ */
+
+typedef struct {
+    uint32_t batches;            // Batches fed into the fit
+    float period_us;             // Current sensor period estimate (local us)
+    int32_t last_residual_us;    // Residual of the latest batch
+    int32_t max_residual_us;     // Largest absolute residual so far
+} ImuTimingStats;
+
+// start_local_us and start_elapsed_ms describe the same instant (micros() and unified ms since sensing start)
+void imu_timing_reset(uint32_t start_local_us, uint32_t start_elapsed_ms, float drift_ratio, uint32_t nominal_rate_hz);
+
+// edges: edges seen so far, first_edge_us: micros() of edge 0, last_since_first_us: edge (edges - 1) relative to edge 0
+void imu_timing_update(uint32_t edges, uint32_t first_edge_us, uint64_t last_since_first_us);
+
+bool imu_timing_ready();                       // At least one edge seen
+uint32_t imu_timing_elapsed_ms(uint32_t edge); // Unified elapsed ms since sensing start of sample `edge`
+const ImuTimingStats &imu_timing_stats();
@@ -0,0 +1,111 @@
+#include <Arduino.h>
+#include <stddef.h>
+#include "journal.hpp"
+#include "crc32.hpp"
+#include "sdcard.hpp"
+
+static_assert(sizeof(JournalRecord) == 40, "JournalRecord must have no padding, the CRC covers every byte");
+
+static uint32_t journal_block = 0;  // Card block of slot 0, 0 until the file is located
+static uint32_t journal_seq = 0;    // Sequence number of the newest record
+
+static uint32_t journal_crc(const JournalRecord &record)
+{
+    return crc32(&record, offsetof(JournalRecord, crc));
+}
+
+// Locate the journal blocks, creating the file on first use
+static bool journal_open()
+{
+    if (journal_block)
+        return true;
+
+    uint32_t last_block;
+    bool created = false;
+    File file = SD.open(JOURNAL_FILE, FILE_READ);
+    if (!file)
+    {
+        file = SD.createContiguous(JOURNAL_FILE, JOURNAL_SLOTS * 512);
+        created = true;
+    }
+
+    bool ok = file && file.size() >= JOURNAL_SLOTS * 512 && file.contiguousRange(journal_block, last_block);
+    if (file)
+        file.close();
+    if (!ok)
+    {
+        journal_block = 0;
+        Serial.println("[SD] Journal unavailable.");
+        return false;
+    }
+
+    // New clusters hold whatever was there before, which could look like a record
+    if (created)
+    {
+        uint8_t zero[512] = {0};
+        for (uint8_t slot = 0; slot < JOURNAL_SLOTS; ++slot)
+        {
+            if (!sdcard_write_block(journal_block + slot, zero))
+            {
+                journal_block = 0;
+                Serial.println("[SD] Journal unavailable.");
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+JournalLoad journal_load(JournalRecord &record)
+{
+    memset(&record, 0, sizeof(record));
+    if (!journal_open())
+        return JournalLoad::FAILED;
+
+    bool found = false;
+    uint8_t block[512];
+    for (uint8_t slot = 0; slot < JOURNAL_SLOTS; ++slot)
+    {
+        // Either slot may hold the newest record, so an unreadable one leaves the state unknown
+        if (!SD.readBlock(journal_block + slot, block))
+        {
+            memset(&record, 0, sizeof(record));
+            Serial.println("[SD] Journal read failed.");
+            return JournalLoad::FAILED;
+        }
+
+        const JournalRecord *candidate = reinterpret_cast<const JournalRecord *>(block);
+        if (candidate->magic != JOURNAL_MAGIC || candidate->crc != journal_crc(*candidate))
+            continue;
+
+        // Wrap-safe comparison of the sequence numbers
+        if (!found || (int32_t)(candidate->seq - record.seq) > 0)
+        {
+            record = *candidate;
+            found = true;
+        }
+    }
+
+    journal_seq = found ? record.seq : 0;
+    return found ? JournalLoad::VALID : JournalLoad::NONE;
+}
+
+bool journal_commit(JournalRecord &record, bool blocking)
+{
+    if (!journal_open())
+        return false;
+
+    record.magic = JOURNAL_MAGIC;
+    record.seq = journal_seq + 1;
+    record.crc = journal_crc(record);
+
+    uint8_t block[512] = {0};
+    memcpy(block, &record, sizeof(record));
+    if (!sdcard_write_block(journal_block + record.seq % JOURNAL_SLOTS, block, blocking))
+    {
+        Serial.println("[SD] Journal write failed.");
+        return false;
+    }
+    journal_seq = record.seq;
+    return true;
+}
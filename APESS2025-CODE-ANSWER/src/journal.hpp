@@ -0,0 +1,50 @@
+#pragma once
+
+#include <stdint.h>
+
+/*
+ * Crash-safe log metadata journal
+ *
+ * /LOG.JNL is a pre-allocated file of two 512-byte slots written with raw
+ * block writes, never through the FAT. Each commit writes the complete
+ * JournalRecord, with the next sequence number and a CRC-32, into the slot
+ * not holding the newest record, so a write torn by a power loss leaves the
+ * previous record intact. At load the valid slot with the highest sequence
+ * number wins.
+ *
+ * Besides the log counter the record tracks the sample log being written:
+ * sensing checkpoints how many of its blocks are on the card, and after a
+ * power loss the boot-time recovery (sensing_recover()) resumes from there.
+ */
+
+#define JOURNAL_FILE  "/LOG.JNL"
+#define JOURNAL_MAGIC 0x4C4A5041UL // "APJL"
+#define JOURNAL_SLOTS 2
+
+#define JOURNAL_FLAG_ACTIVE 0x0001 // active_name is open for writing
+
+typedef struct {
+    uint32_t magic;              // JOURNAL_MAGIC
+    uint32_t seq;                // Commit sequence number, the newest valid slot wins
+    int16_t log_number;          // Last completed log, the next one is log_number + 1
+    uint16_t flags;              // JOURNAL_FLAG_*
+    char active_name[13];        // 8.3 name of the log being written
+    uint8_t reserved[3];
+    uint32_t checkpoint_blocks;  // Blocks of it known to be on the card, header included
+    uint32_t checkpoint_t0_ms;   // t0_ms of the last data block among them
+    uint32_t crc;                // CRC-32 of all fields above
+} JournalRecord;
+
+enum class JournalLoad
+{
+    VALID,  // record is the newest committed one
+    NONE,   // No journal file before this call, or no record ever committed to it
+    FAILED  // Card error: the stored state is unknown and must not be overwritten
+};
+
+// Newest valid record; record is zeroed unless VALID
+JournalLoad journal_load(JournalRecord &record);
+
+// Write `record` as the newest one; fills in magic, seq and crc.
+// Non-blocking the slot is still programming on return, see sdcard_write_block()
+bool journal_commit(JournalRecord &record, bool blocking = true);
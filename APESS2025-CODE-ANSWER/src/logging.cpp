@@ -7,9 +7,13 @@
 // === Log Number Tracker ===
 int16_t log_number = 0;
 
-// Load log number from SD card
-void load_log_number()
+static JournalRecord journal;       // Newest committed record
+static bool journal_read = false;   // journal holds the card's state; nothing is committed until it does
+
+// Counter of the text file the journal replaces
+static int16_t legacy_log_number()
 {
+    int16_t number = 0;
     File logFile = SD.open("/LOG.txt", FILE_READ);
     if (logFile)
     {
@@ -17,27 +21,97 @@ void load_log_number()
         logFile.close();
         if (line.startsWith("LOG_NUM = "))
         {
-            log_number = line.substring(10).toInt();
+            number = line.substring(10).toInt();
         }
     }
-    else
+    return number;
+}
+
+static bool read_journal()
+{
+    JournalLoad loaded = journal_load(journal);
+    journal_read = loaded != JournalLoad::FAILED;
+    if (loaded != JournalLoad::NONE)
+        return journal_read;
+
+    // First boot with the journal: carry the counter over from LOG.txt
+    journal.log_number = legacy_log_number();
+    if (journal_commit(journal))
     {
-        log_number = 0;
+        Serial.print("[SD] Journal created, log number ");
+        Serial.println(journal.log_number);
     }
+    return true;
+}
+
+static void commit_journal(bool blocking = true)
+{
+    // Over an unread record it would roll the log number back, and new logs would replace existing ones
+    if (!journal_read || !journal_commit(journal, blocking))
+    {
+        Serial.println("[SD] Failed to save the log state.");
+    }
+}
+
+// Load log number from SD card
+bool load_log_number()
+{
+    if (!read_journal())
+        return false;
+    log_number = journal.log_number;
+    return true;
 }
 
-// Save log number to SD card (overwrite)
+// Save log number to SD card (the older journal slot is overwritten)
 void save_log_number()
 {
-    File logFile = SD.open("/LOG.txt", O_WRITE | O_CREAT | O_TRUNC);
-    if (logFile)
+    if (!journal_read && !read_journal())
     {
-        logFile.print("LOG_NUM = ");
-        logFile.println(log_number);
-        logFile.close();
+        Serial.println("[SD] Failed to save the log state.");
+        return;
     }
-    else
+    journal.log_number = log_number;
+    commit_journal();
+}
+
+void log_active_begin(const char *name)
+{
+    if (!journal_read && !read_journal())
     {
-        Serial.println("[SD] Failed to open LOG.txt for writing.");
+        Serial.println("[SD] Failed to save the log state.");
+        return;
     }
-}
\ No newline at end of file
+    journal.flags |= JOURNAL_FLAG_ACTIVE;
+    strncpy(journal.active_name, name, sizeof(journal.active_name) - 1);
+    journal.active_name[sizeof(journal.active_name) - 1] = '\0';
+    journal.checkpoint_blocks = 0;
+    journal.checkpoint_t0_ms = 0;
+    commit_journal();
+}
+
+void log_active_checkpoint(uint32_t blocks, uint32_t t0_ms)
+{
+    journal.checkpoint_blocks = blocks;
+    journal.checkpoint_t0_ms = t0_ms;
+    commit_journal(false); // Taken while sampling, which must not wait for the card
+}
+
+void log_active_end(bool completed)
+{
+    if (completed)
+        log_number++;
+    journal.log_number = log_number;
+    journal.flags &= ~JOURNAL_FLAG_ACTIVE;
+    memset(journal.active_name, 0, sizeof(journal.active_name));
+    journal.checkpoint_blocks = 0;
+    journal.checkpoint_t0_ms = 0;
+    commit_journal();
+}
+
+bool log_active_pending(JournalRecord &record)
+{
+    if (!journal_read && !read_journal())
+        return false;
+    record = journal;
+    return journal.flags & JOURNAL_FLAG_ACTIVE;
+}
@@ -1,7 +1,16 @@
 #pragma once
 
-extern int16_t log_number; // Current log number
+#include <stdint.h>
+#include "journal.hpp"
 
-// Load or save the log number from/to SD card
-void load_log_number();
-void save_log_number();
\ No newline at end of file
+extern int16_t log_number; // Last completed log, the next one is log_number + 1
+
+// Load or save the log number from/to SD card (journal, see journal.hpp)
+bool load_log_number(); // false if the journal could not be read: log_number is unchanged and nothing is committed
+void save_log_number();
+
+// Sample log being written, tracked in the journal so boot can recover it after a power loss
+void log_active_begin(const char *name);                 // Log created, before its header block
+void log_active_checkpoint(uint32_t blocks, uint32_t t0_ms); // Blocks on the card so far, t0_ms of the last data block; poll sdcard_log_ready() after it
+void log_active_end(bool completed);                     // Closed; if completed it becomes log_number + 1 in the same write
+bool log_active_pending(JournalRecord &record);          // Log left open by a power loss, if any
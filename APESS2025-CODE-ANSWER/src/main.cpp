@@ -23,6 +23,9 @@
 #include "mqtt.hpp"      // MQTT Communication Functions
 #include "sensing.hpp"   // Sensing Functions
 #include "rf_cmd.hpp"    // RF Command Handling Functions
+#include "rf_bulk.hpp"   // RF Bulk Transfer
+#include "sd_bench.hpp"  // SD Write Benchmark
+#include "catalog.hpp"   // Session Catalog
 
 /*========== HELPERS ==========*/
 uint64_t now_unix_ms = 0; // Current Unix time in milliseconds
@@ -62,6 +65,19 @@ void setup()
         delay(1000); // Retry every second
     }
     node_status.node_flags.sd_ready = true;
+    sdcard_count_free_kb(); // Full FAT scan, done here so status replies only read the count
+    catalog_init();    // Index the sample logs of a card written before the catalog
+    if (!sensing_recover()) // Close a sample log a power loss left open
+    {
+        Serial.println("[ERROR] Log journal unreadable.");
+        node_status.set_state(NodeState::ERROR);
+        return; // loop() reboots from ERROR
+    }
+
+#ifdef SD_BENCHMARK
+    if (!sd_bench_all())
+        Serial.println("[INIT] <SD Card> Benchmark failed, check the card.");
+#endif
 
     // RF Communication Initialization
     if (!rf_init())
@@ -154,7 +170,7 @@ void loop()
         if (node_status.node_flags.reboot_required_leafnode)
         {
             Serial.println("[GATEWAY] Reboot command received for leafnodes.");
-            send_command_with_retry("CMD_REBOOT"); // Send reboot command to all leafnodes
+            send_command_with_retry(rf_message(0, RFReboot{})); // Send reboot command to all leafnodes
         }
         if (node_status.node_flags.reboot_required_gateway)
         {
@@ -176,7 +192,7 @@ void loop()
         if (node_status.node_flags.time_rf_required)
         {
             Serial.println("[GATEWAY] RF time sync requested via MQTT.");
-            send_command_with_retry("CMD_RF_SYNC"); // Send RF sync command
+            send_command_with_retry(rf_message(0, RFSyncRequest{})); // Send RF sync command
             delay(2000);                            // Wait for 1 second to allow RF sync to complete
             node_status.set_state(NodeState::RF_COMMUNICATING);
             rgbled_set_by_state(NodeState::RF_COMMUNICATING);
@@ -206,27 +222,66 @@ void loop()
             node_status.node_flags.sensing_requested = false;
             node_status.node_flags.sensing_scheduled = true;
 
-            // Construct sensing command string: S_YYMMDDHHMMSS_<RATE>_<DUR>
-            char command_buf[32];
-            CalendarTime SensingSchedule = calendar_from_unix_milliseconds(sensing_scheduled_start_ms); // note that the milliseconds are not included in the command
-            snprintf(command_buf, sizeof(command_buf),
-                     "S_%02d%02d%02d%02d%02d%02d_%d_%d",
-                     SensingSchedule.year % 100, // YY
-                     SensingSchedule.month,
-                     SensingSchedule.day,
-                     SensingSchedule.hour,
-                     SensingSchedule.minute,
-                     SensingSchedule.second,
-                     parsed_freq,
-                     parsed_duration);
+            // Start time, rate, duration and profile in one message
+            RFSchedule schedule = {sensing_scheduled_start_ms, parsed_freq, parsed_duration, parsed_range_g, parsed_dlpf_hz};
 
+            char command_buf[96];
+            CalendarTime SensingSchedule = calendar_from_unix_milliseconds(sensing_scheduled_start_ms);
+            snprintf(command_buf, sizeof(command_buf),
+                     "%04d-%02d-%02d %02d:%02d:%02d, %d Hz, %d s, +-%d g, DLPF %d Hz",
+                     SensingSchedule.year, SensingSchedule.month, SensingSchedule.day,
+                     SensingSchedule.hour, SensingSchedule.minute, SensingSchedule.second,
+                     parsed_freq, parsed_duration, parsed_range_g, parsed_dlpf_hz);
             Serial.print("[GATEWAY] Sending sensing command via RF: ");
             Serial.println(command_buf);
 
-            rf_command(command_buf);
+            rf_command(rf_message(0, schedule));
+        }
+#endif
+
+#ifdef GATEWAY
+        // === Pull a sample log from a leaf node over RF (CMD_RF_RETRIEVAL) ===
+        if (node_status.node_flags.rf_retrieval_requested)
+        {
+            node_status.node_flags.rf_retrieval_requested = false;
+            rgbled_set_all(CRGB::Blue);
+            rf_bulk_pull(rf_retrieval_node_id, rf_retrieval_log_number);
+            rgbled_set_by_state(NodeState::IDLE);
+        }
+
+        // === Poll leaf node status (CMD_STATUS) ===
+        if (node_status.node_flags.status_poll_requested)
+        {
+            node_status.node_flags.status_poll_requested = false;
+            rf_poll_status();
+            rf_publish_status();
         }
 #endif
 
+#if defined(GATEWAY) && defined(SENSING_TRIGGER)
+        // === Relay event trigger arming, collect event reports ===
+        if (node_status.node_flags.trigger_relay_required)
+        {
+            node_status.node_flags.trigger_relay_required = false;
+
+            Serial.print("[GATEWAY] Sending trigger command via RF: ");
+            if (node_status.node_flags.trigger_armed)
+            {
+                Serial.print(trigger_rate_hz);
+                Serial.print(" Hz, ");
+                Serial.print(trigger_post_s);
+                Serial.println(" s");
+                rf_command(rf_message(0, RFTriggerOn{trigger_rate_hz, trigger_post_s}));
+            }
+            else
+            {
+                Serial.println("off");
+                rf_command(rf_message(0, RFTriggerOff{}));
+            }
+        }
+        rf_poll_events();
+#endif
+
 #ifdef LEAFNODE
         rf_handle();
 
@@ -302,6 +357,40 @@ void loop()
                 rgbled_set_by_state(NodeState::PREPARING);
             }
         }
+
+#ifdef SENSING_TRIGGER
+        // === Event monitoring, only while nothing else is scheduled ===
+        if (node_status.node_flags.trigger_armed && !node_status.node_flags.sensing_scheduled &&
+            node_status.get_state() == NodeState::IDLE)
+        {
+            if (!node_status.node_flags.trigger_monitoring)
+            {
+                sensing_monitor_begin();
+                node_status.node_flags.trigger_monitoring = true;
+            }
+
+            if (sensing_monitor_poll())
+            {
+                node_status.node_flags.trigger_monitoring = false;
+                if (sensing_trigger_commit(trigger_post_s))
+                {
+                    // Recording continues on the running clock and ends through the normal SAMPLING path
+                    node_status.node_flags.sensing_active = true;
+                    node_status.set_state(NodeState::SAMPLING);
+                    rgbled_set_by_state(NodeState::SAMPLING);
+                }
+                else
+                {
+                    Serial.println("[ERROR] Event recording failed to start.");
+                }
+            }
+        }
+        else if (node_status.node_flags.trigger_monitoring)
+        {
+            sensing_monitor_end();
+            node_status.node_flags.trigger_monitoring = false;
+        }
+#endif
     }
     else if (node_status.get_state() == NodeState::WIFI_COMMUNICATING)
     {
@@ -323,8 +412,8 @@ void loop()
             node_status.node_flags.leafnode_ntp_required = false;
         }
 
-        // check whether need to upload data
-        if (node_status.node_flags.data_retrieval_requested)
+        // check whether need to upload data; a request received meanwhile is served right after
+        while (node_status.node_flags.data_retrieval_requested)
         {
             Serial.print("[COMMUNICATION] <RETRIEVAL> Data retrieval requested. Filename: ");
             Serial.println(retrieval_filename);
@@ -332,6 +421,14 @@ void loop()
             sensing_retrieve_file();
         }
 
+        // check whether to list the sessions on the card
+        if (node_status.node_flags.catalog_list_requested)
+        {
+            Serial.println("[COMMUNICATION] <LIST> Session list requested.");
+            catalog_publish(catalog_from_ms, catalog_to_ms);
+            node_status.node_flags.catalog_list_requested = false;
+        }
+
         // switch to IDLE state after handling WiFi communication
         node_status.set_state(NodeState::IDLE);
         rgbled_set_by_state(NodeState::IDLE);
@@ -372,12 +469,14 @@ void loop()
             // Switch to SAMPLING state
             node_status.set_state(NodeState::SAMPLING);
             rgbled_set_by_state(NodeState::SAMPLING);
+            sensing_start();
         }
     }
     else if (node_status.get_state() == NodeState::SAMPLING)
     {
 
         sensing_sample_once();
+        sensing_flush();
 
         now_unix_ms = Time.get_time();
         if (now_unix_ms > sensing_scheduled_end_ms)
@@ -2,6 +2,14 @@
 
 static MPU6050 mpu(0x68);
 
+#define IMU_FIFO_SIZE 1024 // Bytes of on-chip FIFO
+
+// Data-ready edge stamps, written by the ISR only
+static volatile uint32_t drdy_edges = 0;
+static volatile uint32_t drdy_first_us = 0;
+static volatile uint32_t drdy_prev_us = 0;
+static volatile uint64_t drdy_since_first_us = 0;
+
 void imu_init()
 {
     Wire.begin();
@@ -20,3 +28,226 @@ void imu_get_acceleration(int16_t &ax, int16_t &ay, int16_t &az)
 {
     mpu.getAcceleration(&ax, &ay, &az);
 }
+
+// Accelerometer bandwidth of each DLPF setting, widest first
+static const struct
+{
+    uint8_t mode;
+    uint16_t bandwidth_hz;
+} imu_dlpf_table[] = {
+    {MPU6050_DLPF_BW_256, 260},
+    {MPU6050_DLPF_BW_188, 184},
+    {MPU6050_DLPF_BW_98, 94},
+    {MPU6050_DLPF_BW_42, 44},
+    {MPU6050_DLPF_BW_20, 21},
+    {MPU6050_DLPF_BW_10, 10},
+    {MPU6050_DLPF_BW_5, 5},
+};
+
+#define IMU_DLPF_TABLE_LEN (sizeof(imu_dlpf_table) / sizeof(imu_dlpf_table[0]))
+
+// Clock divided by SMPLRT_DIV; the sample rate it gives is only new accelerometer data up to IMU_BASE_RATE_HZ
+static uint32_t imu_sample_clock_hz(uint8_t dlpf_mode)
+{
+    return dlpf_mode == MPU6050_DLPF_BW_256 ? IMU_CLOCK_NO_DLPF_HZ : IMU_BASE_RATE_HZ;
+}
+
+SensingProfile imu_profile_for(uint32_t rate_hz, uint8_t range_g, uint16_t dlpf_hz, uint8_t decimation)
+{
+    SensingProfile profile;
+    profile.output_rate_hz = rate_hz;
+    profile.decimation = decimation ? decimation : 1;
+
+    uint32_t acq_hz = sensing_acquisition_rate_hz(profile);
+
+    switch (range_g)
+    {
+    case 4:  profile.accel_range = MPU6050_ACCEL_FS_4; break;
+    case 8:  profile.accel_range = MPU6050_ACCEL_FS_8; break;
+    case 16: profile.accel_range = MPU6050_ACCEL_FS_16; break;
+    default: profile.accel_range = MPU6050_ACCEL_FS_2; break;
+    }
+
+    // Narrowest setting unless a wider one fits
+    profile.dlpf_mode = imu_dlpf_table[IMU_DLPF_TABLE_LEN - 1].mode;
+    for (size_t i = 0; i < IMU_DLPF_TABLE_LEN; ++i)
+    {
+        bool fits = dlpf_hz ? imu_dlpf_table[i].bandwidth_hz <= dlpf_hz
+                            : 2UL * imu_dlpf_table[i].bandwidth_hz < acq_hz;
+        if (fits)
+        {
+            profile.dlpf_mode = imu_dlpf_table[i].mode;
+            break;
+        }
+    }
+
+    // Without a divider for acq_hz the sample rate is the accelerometer rate, also with the DLPF off
+    uint32_t clock_hz = imu_sample_clock_hz(profile.dlpf_mode);
+    uint32_t sample_hz = acq_hz > 0 && acq_hz <= IMU_BASE_RATE_HZ && IMU_BASE_RATE_HZ % acq_hz == 0 ? acq_hz : IMU_BASE_RATE_HZ;
+    if (clock_hz / sample_hz <= 256)
+        profile.rate_divider = clock_hz / sample_hz - 1;
+    else
+        profile.rate_divider = clock_hz / IMU_BASE_RATE_HZ - 1;
+
+    return profile;
+}
+
+void imu_apply_profile(const SensingProfile &profile)
+{
+    mpu.setFullScaleAccelRange(profile.accel_range);
+    mpu.setDLPFMode(profile.dlpf_mode);
+    mpu.setRate(profile.rate_divider);
+}
+
+uint8_t imu_range_g(const SensingProfile &profile)
+{
+    return 2 << profile.accel_range;
+}
+
+uint16_t imu_dlpf_bandwidth_hz(const SensingProfile &profile)
+{
+    for (size_t i = 0; i < IMU_DLPF_TABLE_LEN; ++i)
+    {
+        if (imu_dlpf_table[i].mode == profile.dlpf_mode)
+            return imu_dlpf_table[i].bandwidth_hz;
+    }
+    return 0;
+}
+
+uint32_t imu_sensor_rate_hz(const SensingProfile &profile)
+{
+    uint32_t sample_hz = imu_sample_clock_hz(profile.dlpf_mode) / (1 + profile.rate_divider);
+    return min(sample_hz, (uint32_t)IMU_BASE_RATE_HZ); // Faster sample rates repeat accelerometer data
+}
+
+float imu_lsb_per_g(const SensingProfile &profile)
+{
+    return 16384.0f / (1 << profile.accel_range);
+}
+
+bool imu_fifo_supported(const SensingProfile &profile)
+{
+    uint32_t acq_hz = sensing_acquisition_rate_hz(profile);
+    return acq_hz > 0 && acq_hz <= IMU_BASE_RATE_HZ && imu_sensor_rate_hz(profile) == acq_hz &&
+           IMU_BASE_RATE_HZ % acq_hz == 0;
+}
+
+bool imu_fifo_begin(const SensingProfile &profile)
+{
+    if (!imu_fifo_supported(profile))
+        return false;
+
+    // Accelerometer only, so each FIFO record is exactly 6 bytes
+    mpu.setFIFOEnabled(false);
+    mpu.setTempFIFOEnabled(false);
+    mpu.setXGyroFIFOEnabled(false);
+    mpu.setYGyroFIFOEnabled(false);
+    mpu.setZGyroFIFOEnabled(false);
+    mpu.setAccelFIFOEnabled(true);
+    mpu.setIntFIFOBufferOverflowEnabled(true); // Latches the overflow flag in INT_STATUS
+
+    mpu.resetFIFO();
+    mpu.getIntStatus(); // Clear a stale overflow flag
+    mpu.setFIFOEnabled(true);
+    return true;
+}
+
+void imu_fifo_end()
+{
+    mpu.setFIFOEnabled(false);
+    mpu.setAccelFIFOEnabled(false);
+    mpu.setIntFIFOBufferOverflowEnabled(false);
+    mpu.resetFIFO();
+}
+
+int imu_fifo_read(int16_t (*xyz)[3], uint16_t max_samples, uint32_t *first_edge)
+{
+    // The oldest queued record belongs to edge (edges - queued) if no edge arrived meanwhile
+    uint32_t edges_before = drdy_edges;
+    uint16_t fifo_count = mpu.getFIFOCount();
+    uint32_t edges_after = drdy_edges;
+
+    // 1024 is not a multiple of 6, so after an overflow the records are misaligned
+    if (mpu.getIntFIFOBufferOverflowStatus() || fifo_count >= IMU_FIFO_SIZE)
+    {
+        mpu.resetFIFO();
+        return -1;
+    }
+
+    uint16_t available = fifo_count / IMU_FIFO_SAMPLE_BYTES;
+    if (first_edge)
+    {
+        *first_edge = (edges_before == edges_after && edges_after >= available) ? edges_after - available : IMU_EDGE_UNKNOWN;
+    }
+    uint16_t total = available < max_samples ? available : max_samples;
+    uint8_t raw[IMU_FIFO_BURST_SAMPLES * IMU_FIFO_SAMPLE_BYTES];
+
+    for (uint16_t done = 0; done < total;)
+    {
+        uint16_t burst = total - done;
+        if (burst > IMU_FIFO_BURST_SAMPLES)
+            burst = IMU_FIFO_BURST_SAMPLES;
+
+        mpu.getFIFOBytes(raw, burst * IMU_FIFO_SAMPLE_BYTES);
+
+        for (uint16_t i = 0; i < burst; ++i)
+        {
+            const uint8_t *p = &raw[i * IMU_FIFO_SAMPLE_BYTES];
+            xyz[done + i][0] = (int16_t)((p[0] << 8) | p[1]);
+            xyz[done + i][1] = (int16_t)((p[2] << 8) | p[3]);
+            xyz[done + i][2] = (int16_t)((p[4] << 8) | p[5]);
+        }
+        done += burst;
+    }
+
+    return total;
+}
+
+static void imu_drdy_isr()
+{
+    uint32_t now = micros();
+
+    if (drdy_edges == 0)
+    {
+        drdy_first_us = now;
+    }
+    else
+    {
+        drdy_since_first_us = drdy_since_first_us + (uint32_t)(now - drdy_prev_us);
+    }
+    drdy_prev_us = now;
+    drdy_edges = drdy_edges + 1;
+}
+
+void imu_drdy_begin(uint8_t int_pin)
+{
+    noInterrupts();
+    drdy_edges = 0;
+    drdy_first_us = 0;
+    drdy_since_first_us = 0;
+    interrupts();
+
+    // Active high, push-pull, 50 us pulse per sample
+    mpu.setInterruptMode(false);
+    mpu.setInterruptDrive(false);
+    mpu.setInterruptLatch(false);
+    mpu.setIntDataReadyEnabled(true);
+
+    pinMode(int_pin, INPUT);
+    attachInterrupt(digitalPinToInterrupt(int_pin), imu_drdy_isr, RISING);
+}
+
+void imu_drdy_end(uint8_t int_pin)
+{
+    detachInterrupt(digitalPinToInterrupt(int_pin));
+    mpu.setIntDataReadyEnabled(false);
+}
+
+void imu_drdy_snapshot(uint32_t &edges, uint32_t &first_us, uint64_t &last_since_first_us)
+{
+    noInterrupts();
+    edges = drdy_edges;
+    first_us = drdy_first_us;
+    last_since_first_us = drdy_since_first_us;
+    interrupts();
+}
@@ -2,9 +2,65 @@
 #include <Arduino.h>
 #include <Wire.h>
 #include <MPU6050.h>
+#include "sensing.hpp"
+
+#define IMU_BASE_RATE_HZ 1000      // Accelerometer output rate in every DLPF mode, the highest acquisition rate
+#define IMU_CLOCK_NO_DLPF_HZ 8000  // SMPLRT_DIV input with the DLPF off (gyro rate); the accelerometer still updates at 1 kHz
+#define IMU_FIFO_SAMPLE_BYTES 6    // Accelerometer X/Y/Z, big-endian int16 each
+#define IMU_FIFO_BURST_SAMPLES 42  // Samples per getFIFOBytes() call (length is uint8_t)
+#define IMU_INT_PIN 2              // MPU6050 INT, only used with IMU_DRDY_INTERRUPT
+#define IMU_EDGE_UNKNOWN 0xFFFFFFFFUL
 
 // Initialize MPU6050
 void imu_init();
 
 // Read raw 3-axis acceleration values
 void imu_get_acceleration(int16_t &ax, int16_t &ay, int16_t &az);
+
+/*
+ * Sensing profile
+ *
+ * range_g selects the full scale (2, 4, 8 or 16 g). The IMU is read at
+ * rate_hz * decimation. dlpf_hz == 0 picks the widest DLPF bandwidth below the
+ * Nyquist frequency of that acquisition rate; otherwise the widest bandwidth
+ * not above dlpf_hz. The divider makes the sensor clock equal to the
+ * acquisition rate when the base rate allows it, else the sensor runs at its
+ * base rate and the MCU picks samples from the filtered output. Acquisition
+ * rates above IMU_BASE_RATE_HZ would repeat accelerometer samples; commands
+ * are rejected before they get here.
+ */
+SensingProfile imu_profile_for(uint32_t rate_hz, uint8_t range_g, uint16_t dlpf_hz, uint8_t decimation = 1);
+void imu_apply_profile(const SensingProfile &profile);
+uint8_t imu_range_g(const SensingProfile &profile);
+uint16_t imu_dlpf_bandwidth_hz(const SensingProfile &profile);
+uint32_t imu_sensor_rate_hz(const SensingProfile &profile);
+float imu_lsb_per_g(const SensingProfile &profile);
+
+/*
+ * FIFO acquisition mode
+ *
+ * The sensor clock paces sampling: with a profile whose sensor rate equals its
+ * acquisition rate, the accelerometer is pushed into the 1 KB on-chip FIFO and the
+ * MCU drains many samples per I2C burst. imu_fifo_read() returns the number of
+ * samples copied into xyz, or -1 if the FIFO overflowed since the last read;
+ * the FIFO is then reset and the caller has lost an unknown number of samples.
+ * With the data-ready interrupt running, first_edge receives the edge index of
+ * the first returned sample, or IMU_EDGE_UNKNOWN if an edge raced the count.
+ */
+bool imu_fifo_supported(const SensingProfile &profile);
+bool imu_fifo_begin(const SensingProfile &profile); // Profile must already be applied
+void imu_fifo_end();
+int imu_fifo_read(int16_t (*xyz)[3], uint16_t max_samples, uint32_t *first_edge = nullptr);
+
+/*
+ * Data-ready interrupt
+ *
+ * The MPU6050 pulses INT for every new sample. The ISR counts the edges and
+ * stamps them with micros(): the first edge, and the latest edge relative to
+ * the first as 64 bits so sessions longer than the micros() wrap still work.
+ * Edge indices count every sample since imu_drdy_begin(); imu_fifo_read()
+ * maps FIFO records onto them.
+ */
+void imu_drdy_begin(uint8_t int_pin);     // Call before imu_fifo_begin()
+void imu_drdy_end(uint8_t int_pin);
+void imu_drdy_snapshot(uint32_t &edges, uint32_t &first_us, uint64_t &last_since_first_us);
@@ -4,6 +4,11 @@
 WiFiClient wifi_client;
 PubSubClient mqtt_client(wifi_client);
 char retrieval_filename[32];
+char retrieval_chunks[RETRIEVAL_CHUNKS_MAX];
+uint64_t catalog_from_ms = 0;
+uint64_t catalog_to_ms = UINT64_MAX;
+uint8_t rf_retrieval_node_id = 0;
+uint16_t rf_retrieval_log_number = 0;
 
 // to slow down MQTT loop
 bool should_run_mqtt_loop()
@@ -15,6 +15,30 @@ extern PubSubClient mqtt_client;
 // === Retrieval Filename
 extern char retrieval_filename[32];
 
+// === Retrieval Range
+// Chunks of RETRIEVAL_CHUNK_SIZE bytes, numbered from 1, to publish: "a", "a-b" or "a-" (to the end),
+// comma separated; empty for the whole file. See sensing_retrieve_file().
+// Chunks are streamed from the card, so messages are not bound by MQTT_MAX_PACKET_SIZE; one carries
+// up to PACER_UNITS_MAX consecutive chunks depending on the link. Whole sectors keep card reads aligned
+#define RETRIEVAL_CHUNK_SIZE 1024
+#define RETRIEVAL_CHUNKS_MAX 128
+extern char retrieval_chunks[RETRIEVAL_CHUNKS_MAX];
+
+// === Acknowledged Retrieval (RETRIEVAL_ACK)
+// Up to RETRIEVAL_WINDOW messages stay in flight; the server acknowledges the chunks it received intact
+// with CMD_ACK_<name>:<chunks>, and a message not acknowledged within the timeout is sent again
+#define RETRIEVAL_WINDOW       8
+#define RETRIEVAL_SENDS_MAX    5     // Sends of a message before its chunks count as missing
+#define RETRIEVAL_RTO_START_MS 3000  // Timeout until round trips have been measured
+#define RETRIEVAL_RTO_MIN_MS   1000
+#define RETRIEVAL_RTO_MAX_MS   15000
+
+// === Session List Range (CMD_LIST), Unix ms, start times in [from, to)
+extern uint64_t catalog_from_ms;
+extern uint64_t catalog_to_ms;
+extern uint8_t rf_retrieval_node_id;     // CMD_RF_RETRIEVAL: leaf node and log to pull over RF
+extern uint16_t rf_retrieval_log_number;
+
 // to slow down MQTT loop
 bool should_run_mqtt_loop();
 
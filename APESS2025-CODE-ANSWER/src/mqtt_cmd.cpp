@@ -2,10 +2,81 @@
 #include "rgbled.hpp"
 #include "time.hpp"
 #include "timesync.hpp"
+#include "sample_format.hpp"
+#include "catalog.hpp"
+#include "sensing.hpp"
+#include "mpu6050.hpp"
 
 // Parsed Command Variables
 char cmd_sensing_raw[128];
 
+// The accelerometer outputs at most IMU_BASE_RATE_HZ, a higher rate would only store repeated samples
+static bool sensing_rate_valid(int rate_hz)
+{
+    return rate_hz > 0 && rate_hz <= IMU_BASE_RATE_HZ;
+}
+
+// Parse the optional profile suffix after the duration, "_<G>g" and/or "_<BW>bw", into parsed_range_g / parsed_dlpf_hz
+static void parse_sensing_profile(const char *suffix)
+{
+    parsed_range_g = default_sensing_range_g;
+    parsed_dlpf_hz = 0; // Picked from the sensing rate
+
+    int value, consumed;
+    char unit[3];
+    while (sscanf(suffix, "_%d%2[a-z]%n", &value, unit, &consumed) == 2)
+    {
+        if (strcmp(unit, "g") == 0 && (value == 2 || value == 4 || value == 8 || value == 16))
+        {
+            parsed_range_g = value;
+        }
+        else if (strcmp(unit, "bw") == 0 && value > 0)
+        {
+            parsed_dlpf_hz = value;
+        }
+        else
+        {
+            Serial.print("[MQTT] Ignoring invalid profile option: ");
+            Serial.println(suffix);
+        }
+        suffix += consumed;
+    }
+}
+
+// Parse the optional range suffix of a retrieval into retrieval_chunks: ":<chunks>", a list of
+// "a", "a-b" and "a-" chunk ranges, or "@<from>[-<to>]" in bytes, mapped onto the chunks holding them
+static bool parse_retrieval_range(const char *suffix)
+{
+    retrieval_chunks[0] = '\0';
+    if (*suffix == '\0')
+        return true; // Whole file
+
+    if (*suffix == ':')
+    {
+        const char *list = suffix + 1;
+        size_t len = strlen(list);
+        if (len == 0 || len >= sizeof(retrieval_chunks) || strspn(list, "0123456789,-") != len)
+            return false;
+        memcpy(retrieval_chunks, list, len + 1);
+        return true;
+    }
+
+    unsigned long from, to;
+    int consumed = 0;
+    if (sscanf(suffix, "@%lu-%lu%n", &from, &to, &consumed) == 2 && suffix[consumed] == '\0' && to > from)
+    {
+        snprintf(retrieval_chunks, sizeof(retrieval_chunks), "%lu-%lu",
+                 from / RETRIEVAL_CHUNK_SIZE + 1, (to - 1) / RETRIEVAL_CHUNK_SIZE + 1);
+        return true;
+    }
+    if (sscanf(suffix, "@%lu%n", &from, &consumed) == 1 && suffix[consumed] == '\0')
+    {
+        snprintf(retrieval_chunks, sizeof(retrieval_chunks), "%lu-", from / RETRIEVAL_CHUNK_SIZE + 1);
+        return true;
+    }
+    return false;
+}
+
 // Callback when subscribed message is received
 void mqtt_callback(char *topic, byte *payload, unsigned int length)
 {
@@ -80,6 +151,9 @@ void mqtt_callback(char *topic, byte *payload, unsigned int length)
 
         parsed_freq = default_sensing_rate_hz;    // global variable at config.hpp
         parsed_duration = default_sensing_duration_s; // global variable at config.hpp
+        parse_sensing_profile("");                // Default range, DLPF from the rate table
+        sensing_range_g = parsed_range_g;
+        sensing_dlpf_hz = parsed_dlpf_hz;
 
         sensing_scheduled_start_ms = now_unix_ms_rounded + TIME_SYNC_RESERVED_TIME;
         sensing_scheduled_end_ms = sensing_scheduled_start_ms + (sensing_duration_s * 1000);
@@ -110,7 +184,8 @@ void mqtt_callback(char *topic, byte *payload, unsigned int length)
         node_status.node_flags.time_rf_required = true;
 
         int delay_sec, freq, duration;
-        int matched = sscanf(message, "CMD_SFN_%d_%dHz_%ds", &delay_sec, &freq, &duration);
+        int consumed = 0;
+        int matched = sscanf(message, "CMD_SFN_%d_%dHz_%ds%n", &delay_sec, &freq, &duration, &consumed);
 
         if (matched == 3)
         {
@@ -123,6 +198,15 @@ void mqtt_callback(char *topic, byte *payload, unsigned int length)
                 if (node_status.get_state() == NodeState::IDLE)
                     rgbled_set_by_state(NodeState::IDLE);
             }
+            else if (!sensing_rate_valid(freq))
+            {
+                Serial.println("[MQTT] CMD_SFN rejected: rate above the accelerometer output rate.");
+                mqtt_client.publish(MQTT_TOPIC_PUB, "CMD_SFN ignored: rate must be 1-1000 Hz.");
+                rgbled_set_all(CRGB::Red); // Visual error indication
+                delay(3000);
+                if (node_status.get_state() == NodeState::IDLE)
+                    rgbled_set_by_state(NodeState::IDLE);
+            }
             else
             {
                 uint64_t now_unix_ms = Time.get_time();
@@ -134,6 +218,9 @@ void mqtt_callback(char *topic, byte *payload, unsigned int length)
 
                 parsed_freq = freq;    // global variable at config.hpp
                 parsed_duration = duration; // global variable at config.hpp
+                parse_sensing_profile(message + consumed);
+                sensing_range_g = parsed_range_g;
+                sensing_dlpf_hz = parsed_dlpf_hz;
 
                 node_status.node_flags.sensing_requested = true;
                 node_status.node_flags.sensing_scheduled = true;
@@ -172,9 +259,10 @@ void mqtt_callback(char *topic, byte *payload, unsigned int length)
 
         int y, mo, d, h, mi, s;
         int rate, dur;
+        int consumed = 0;
         int matched = sscanf(message,
-                             "CMD_SENSING_%d-%d-%d_%d:%d:%d_%dHz_%ds",
-                             &y, &mo, &d, &h, &mi, &s, &rate, &dur);
+                             "CMD_SENSING_%d-%d-%d_%d:%d:%d_%dHz_%ds%n",
+                             &y, &mo, &d, &h, &mi, &s, &rate, &dur, &consumed);
         int ms_value = 0;
 
         if (matched == 8)
@@ -190,11 +278,28 @@ void mqtt_callback(char *topic, byte *payload, unsigned int length)
 
             parsed_freq = rate;    // global variable at config.hpp
             parsed_duration = dur; // global variable at config.hpp
+            parse_sensing_profile(message + consumed); // Optional "_<G>g_<BW>bw"
 
             uint64_t now_unix_ms = Time.get_time();
             uint64_t parsed_temp_sensing_start_ms = unix_from_calendar_milliseconds(ParseTime);
 
-            if (now_unix_ms > parsed_temp_sensing_start_ms)
+            if (!sensing_rate_valid(rate))
+            {
+                Serial.println("[MQTT] Sensing rate above the accelerometer output rate, ignoring command.");
+                node_status.node_flags.sensing_requested = false;
+                node_status.node_flags.sensing_scheduled = false;
+
+                // feedback to the mqtt broker
+                mqtt_client.publish(MQTT_TOPIC_PUB, "Sensing command ignored: rate must be 1-1000 Hz!");
+
+                rgbled_set_all(CRGB::Red); // Set LED to red to indicate error
+                delay(3000);
+                if (node_status.get_state() == NodeState::IDLE)
+                {
+                    rgbled_set_by_state(NodeState::IDLE); // Reset LED to IDLE state
+                }
+            }
+            else if (now_unix_ms > parsed_temp_sensing_start_ms)
             {
                 Serial.println("[MQTT] Sensing start time is in the past, ignoring command.");
                 node_status.node_flags.sensing_requested = false;
@@ -233,6 +338,8 @@ void mqtt_callback(char *topic, byte *payload, unsigned int length)
                 sensing_scheduled_end_ms = sensing_scheduled_start_ms + (parsed_duration * 1000);
                 sensing_rate_hz = parsed_freq;
                 sensing_duration_s = parsed_duration;
+                sensing_range_g = parsed_range_g;
+                sensing_dlpf_hz = parsed_dlpf_hz;
 
                 node_status.node_flags.sensing_scheduled = true;
 
@@ -250,10 +357,105 @@ void mqtt_callback(char *topic, byte *payload, unsigned int length)
             node_status.node_flags.sensing_requested = false;
         }
     }
+    else if (msg_str == "CMD_LIST" || msg_str.startsWith("CMD_LIST_"))
+    {
+        // CMD_LIST, or CMD_LIST_<Y-M-D_h:m:s>_<Y-M-D_h:m:s> for sessions starting in that range
+        Serial.println("[COMMUNICATION] <CMD> CMD_LIST received.");
+
+        CalendarTime from, to;
+        memset(&from, 0, sizeof(from));
+        memset(&to, 0, sizeof(to));
+        int from_y, from_mo, from_d, from_h, from_mi, from_s;
+        int to_y, to_mo, to_d, to_h, to_mi, to_s;
+        if (msg_str == "CMD_LIST")
+        {
+            catalog_from_ms = 0;
+            catalog_to_ms = UINT64_MAX;
+        }
+        else if (sscanf(message, "CMD_LIST_%d-%d-%d_%d:%d:%d_%d-%d-%d_%d:%d:%d",
+                        &from_y, &from_mo, &from_d, &from_h, &from_mi, &from_s,
+                        &to_y, &to_mo, &to_d, &to_h, &to_mi, &to_s) == 12)
+        {
+            from.year = from_y;
+            from.month = from_mo;
+            from.day = from_d;
+            from.hour = from_h;
+            from.minute = from_mi;
+            from.second = from_s;
+            to.year = to_y;
+            to.month = to_mo;
+            to.day = to_d;
+            to.hour = to_h;
+            to.minute = to_mi;
+            to.second = to_s;
+            catalog_from_ms = unix_from_calendar_milliseconds(from);
+            catalog_to_ms = unix_from_calendar_milliseconds(to);
+        }
+        else
+        {
+            Serial.println("[MQTT] CMD_LIST format error.");
+            mqtt_client.publish(MQTT_TOPIC_PUB, "CMD_LIST ignored: invalid format.");
+            return;
+        }
+
+        node_status.node_flags.catalog_list_requested = true;
+
+        // switch to COMMUNICATING state
+        node_status.set_state(NodeState::WIFI_COMMUNICATING);
+        rgbled_set_all(CRGB::Blue);
+    }
+    else if (msg_str.startsWith("CMD_ACK_"))
+    {
+        // CMD_ACK_<name>:<chunks>, chunks of an acknowledged retrieval (RETRIEVAL_ACK) the server received intact
+        char *chunks = strchr(message + 8, ':');
+        if (chunks)
+        {
+            *chunks++ = '\0';
+            sensing_retrieve_ack(message + 8, chunks);
+        }
+    }
+    else if (msg_str.startsWith("CMD_RETRIEVAL_LOG_"))
+    {
+        // Retrieval by log number, the file name comes from the catalog
+        int log = -1;
+        int consumed = 0;
+        CatalogEntry entry;
+        if (sscanf(message, "CMD_RETRIEVAL_LOG_%d%n", &log, &consumed) != 1 || !parse_retrieval_range(message + consumed))
+        {
+            Serial.println("[MQTT] CMD_RETRIEVAL_LOG format error.");
+            mqtt_client.publish(MQTT_TOPIC_PUB, "CMD_RETRIEVAL_LOG ignored: invalid format.");
+            return;
+        }
+        if (log < 0 || !catalog_find(log, entry))
+        {
+            Serial.println("[MQTT] CMD_RETRIEVAL_LOG: log not in the catalog.");
+            mqtt_client.publish(MQTT_TOPIC_PUB, "CMD_RETRIEVAL_LOG ignored: log not in the catalog.");
+            return;
+        }
+
+        snprintf(retrieval_filename, sizeof(retrieval_filename), "/N%03u_%03u" SAMPLE_FILE_EXT, entry.node_id, entry.log_number);
+        node_status.node_flags.data_retrieval_requested = true;
+        node_status.node_flags.data_retrieval_sent = false;
+
+        Serial.print("[COMMUNICATION] <CMD> CMD_RETRIEVAL_LOG received: ");
+        Serial.println(retrieval_filename);
+
+        // switch to COMMUNICATING state
+        node_status.set_state(NodeState::WIFI_COMMUNICATING);
+        rgbled_set_all(CRGB::Blue); // Set LED to blue during data retrieval
+    }
     else if (msg_str.startsWith("CMD_RETRIEVAL_"))
     {
+        // CMD_RETRIEVAL_<name>, optionally followed by ":<chunks>" or "@<from>[-<to>]" to resend part of it
         const char *filename_part = message + 14;
-        snprintf(retrieval_filename, sizeof(retrieval_filename), "/%s.txt", filename_part);
+        int name_len = strcspn(filename_part, ":@");
+        if (!parse_retrieval_range(filename_part + name_len))
+        {
+            Serial.println("[MQTT] CMD_RETRIEVAL range format error.");
+            mqtt_client.publish(MQTT_TOPIC_PUB, "CMD_RETRIEVAL ignored: invalid range.");
+            return;
+        }
+        snprintf(retrieval_filename, sizeof(retrieval_filename), "/%.*s" SAMPLE_FILE_EXT, name_len, filename_part);
         node_status.node_flags.data_retrieval_requested = true;
         node_status.node_flags.data_retrieval_sent = false; // Reset sent flag for new retrieval
 
@@ -264,6 +466,82 @@ void mqtt_callback(char *topic, byte *payload, unsigned int length)
         node_status.set_state(NodeState::WIFI_COMMUNICATING);
         rgbled_set_all(CRGB::Blue); // Set LED to blue during data retrieval
     }
+    else if (msg_str.startsWith("CMD_SUMMARY_"))
+    {
+        // Spectrum summary of a session, published like a retrieval
+        const char *filename_part = message + 12;
+        int name_len = strcspn(filename_part, ":@");
+        if (!parse_retrieval_range(filename_part + name_len))
+        {
+            Serial.println("[MQTT] CMD_SUMMARY range format error.");
+            mqtt_client.publish(MQTT_TOPIC_PUB, "CMD_SUMMARY ignored: invalid range.");
+            return;
+        }
+        snprintf(retrieval_filename, sizeof(retrieval_filename), "/%.*s" SPECTRUM_FILE_EXT, name_len, filename_part);
+        node_status.node_flags.data_retrieval_requested = true;
+        node_status.node_flags.data_retrieval_sent = false;
+
+        Serial.print("[COMMUNICATION] <CMD> CMD_SUMMARY received: ");
+        Serial.println(retrieval_filename);
+
+        // switch to COMMUNICATING state
+        node_status.set_state(NodeState::WIFI_COMMUNICATING);
+        rgbled_set_all(CRGB::Blue); // Set LED to blue during data retrieval
+    }
+#ifdef SENSING_TRIGGER
+    else if (msg_str.startsWith("CMD_TRIGGER_ON"))
+    {
+        // CMD_TRIGGER_ON or CMD_TRIGGER_ON_<RATE>Hz_<POST>s
+        int rate = trigger_rate_hz, post_s = trigger_post_s;
+        if (msg_str != "CMD_TRIGGER_ON" &&
+            (sscanf(message, "CMD_TRIGGER_ON_%dHz_%ds", &rate, &post_s) != 2 || !sensing_rate_valid(rate) || post_s <= 0))
+        {
+            Serial.println("[MQTT] CMD_TRIGGER_ON format error.");
+            mqtt_client.publish(MQTT_TOPIC_PUB, "CMD_TRIGGER_ON ignored: invalid format.");
+        }
+        else
+        {
+            trigger_rate_hz = rate;
+            trigger_post_s = post_s;
+            node_status.node_flags.trigger_armed = true;
+            node_status.node_flags.trigger_relay_required = true;
+
+            char buf[96];
+            snprintf(buf, sizeof(buf), "[MQTT] Event trigger armed: %d Hz, %d s after each event", rate, post_s);
+            Serial.println(buf);
+            mqtt_client.publish(MQTT_TOPIC_PUB, "CMD_TRIGGER_ON: Event trigger armed.");
+        }
+    }
+    else if (msg_str == "CMD_TRIGGER_OFF")
+    {
+        node_status.node_flags.trigger_armed = false;
+        node_status.node_flags.trigger_relay_required = true;
+        Serial.println("[COMMUNICATION] <CMD> CMD_TRIGGER_OFF received.");
+        mqtt_client.publish(MQTT_TOPIC_PUB, "CMD_TRIGGER_OFF: Event trigger disarmed.");
+    }
+#endif
+    else if (msg_str.startsWith("CMD_RF_RETRIEVAL_"))
+    {
+        // CMD_RF_RETRIEVAL_N<node>_<log>: the gateway pulls the log from the leaf node over RF and relays it
+        int node = 0, log = -1;
+        if (sscanf(message, "CMD_RF_RETRIEVAL_N%d_%d", &node, &log) != 2 || node < 1 || node > NUM_NODES || log < 0)
+        {
+            Serial.println("[MQTT] CMD_RF_RETRIEVAL format error.");
+            mqtt_client.publish(MQTT_TOPIC_PUB, "CMD_RF_RETRIEVAL ignored: invalid format.");
+            return;
+        }
+
+        rf_retrieval_node_id = node;
+        rf_retrieval_log_number = log;
+        node_status.node_flags.rf_retrieval_requested = true;
+        Serial.println("[COMMUNICATION] <CMD> CMD_RF_RETRIEVAL received.");
+    }
+    else if (msg_str == "CMD_STATUS")
+    {
+        // Leaf node status, polled over RF by the gateway
+        node_status.node_flags.status_poll_requested = true;
+        Serial.println("[COMMUNICATION] <CMD> CMD_STATUS received.");
+    }
     else if (msg_str == "CMD_REBOOT")
     {
         node_status.node_flags.reboot_required_gateway = true;
@@ -24,37 +24,34 @@ NodeState NodeStatusManager::get_state() const
     return node_state;
 }
 
-// Print current state and flags
-void NodeStatusManager::print_state() const
+const char *node_state_name(NodeState state)
 {
-    Serial.print("[STATUS] Current state: ");
-    switch (node_state)
+    switch (state)
     {
     case NodeState::BOOT:
-        Serial.println("BOOT");
-        break;
+        return "BOOT";
     case NodeState::IDLE:
-        Serial.println("IDLE");
-        break;
+        return "IDLE";
     case NodeState::PREPARING:
-        Serial.println("PREPARING");
-        break;
+        return "PREPARING";
     case NodeState::SAMPLING:
-        Serial.println("SAMPLING");
-        break;
+        return "SAMPLING";
     case NodeState::RF_COMMUNICATING:
-        Serial.println("RF_COMMUNICATING");
-        break;
+        return "RF_COMMUNICATING";
     case NodeState::WIFI_COMMUNICATING:
-        Serial.println("WIFI_COMMUNICATING");
-        break;
+        return "WIFI_COMMUNICATING";
     case NodeState::ERROR:
-        Serial.println("ERROR");
-        break;
+        return "ERROR";
     default:
-        Serial.println("UNKNOWN");
-        break;
+        return "UNKNOWN";
     }
+}
+
+// Print current state and flags
+void NodeStatusManager::print_state() const
+{
+    Serial.print("[STATUS] Current state: ");
+    Serial.println(node_state_name(node_state));
 
     Serial.println("<NodeFlags> Initialization:");
     Serial.print("  Serial Ready: ");
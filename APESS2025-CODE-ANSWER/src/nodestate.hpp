@@ -42,9 +42,19 @@ struct NodeFlags
     bool sensing_scheduled = false; // Sensing schedule status
     bool sensing_active = false;    // Sensing activity status
 
+    // Event Trigger Flags
+    bool trigger_armed = false;      // Event recording armed (CMD_TRIGGER_ON)
+    bool trigger_monitoring = false; // Sampling into the pre-trigger ring in IDLE
+    bool trigger_relay_required = false; // Gateway: arm / disarm command still to be sent over RF
+
     // Data Logging Flags
     bool data_retrieval_requested = false; // Data retrieval request status
     bool data_retrieval_sent = true;       // Data retrieval sent status, by default true, meaning already sent
+    bool catalog_list_requested = false;   // CMD_LIST received, catalog entries still to be published
+    bool rf_retrieval_requested = false;   // Gateway: CMD_RF_RETRIEVAL received, log still to be pulled from a leaf node
+
+    // Telemetry Flags
+    bool status_poll_requested = false; // Gateway: CMD_STATUS received, leaf nodes still to be polled
 };
 
 // === State Manager ===
@@ -66,5 +76,8 @@ public:
     void print_state() const;
 };
 
+// State name for logs, "UNKNOWN" if out of range
+const char *node_state_name(NodeState state);
+
 // Global instance
 extern NodeStatusManager node_status;
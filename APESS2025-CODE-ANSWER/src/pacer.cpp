@@ -0,0 +1,51 @@
+#include "pacer.hpp"
+
+void pacer_reset(Pacer &pacer)
+{
+    pacer.units = 1;
+    pacer.gap_ms = PACER_GAP_START_MS;
+    pacer.us_per_kb = 0;
+    pacer.increases = 0;
+    pacer.decreases = 0;
+}
+
+// Multiplicative decrease
+static void pacer_back_off(Pacer &pacer, uint8_t divisor)
+{
+    pacer.units = pacer.units / divisor > 0 ? pacer.units / divisor : 1;
+    uint32_t gap_ms = (uint32_t)pacer.gap_ms * 2 + PACER_GAP_STEP_MS;
+    pacer.gap_ms = gap_ms < PACER_GAP_MAX_MS ? gap_ms : PACER_GAP_MAX_MS;
+    pacer.decreases++;
+}
+
+void pacer_update(Pacer &pacer, bool ok, uint32_t bytes, uint32_t send_us)
+{
+    if (!ok || bytes == 0)
+    {
+        // Lost the connection or the message: restart small, the pace is no longer known
+        pacer_back_off(pacer, PACER_UNITS_MAX);
+        pacer.us_per_kb = 0;
+        return;
+    }
+
+    uint32_t us_per_kb = (uint64_t)send_us * 1024 / bytes;
+    if (pacer.us_per_kb == 0)
+        pacer.us_per_kb = us_per_kb;
+
+    bool slow = us_per_kb > (uint64_t)pacer.us_per_kb * PACER_SLOW_FACTOR;
+
+    // Smoothed over about four messages; congested ones count too, so a lasting change becomes the new pace
+    pacer.us_per_kb = (int32_t)pacer.us_per_kb + ((int32_t)us_per_kb - (int32_t)pacer.us_per_kb) / 4;
+
+    if (slow)
+    {
+        pacer_back_off(pacer, 2);
+        return;
+    }
+
+    // Additive increase
+    if (pacer.units < PACER_UNITS_MAX)
+        pacer.units++;
+    pacer.gap_ms = pacer.gap_ms > PACER_GAP_STEP_MS ? pacer.gap_ms - PACER_GAP_STEP_MS : 0;
+    pacer.increases++;
+}
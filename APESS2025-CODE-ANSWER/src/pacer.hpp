@@ -0,0 +1,38 @@
+#pragma once
+
+#include <stdint.h>
+
+/*
+ * Pacer - AIMD flow control for bulk transfers over a link of unknown quality
+ *
+ * The sender reports how long each message took to hand to the link. The
+ * smoothed time per KB is the link's current pace; a message that takes more
+ * than PACER_SLOW_FACTOR times that, or fails, means the link (or the WiFi
+ * module's buffers) is backing up. The pacer then halves the message size
+ * and doubles the pause between messages (multiplicative decrease). Every
+ * message at the usual pace adds one unit to the size and takes one step off
+ * the pause (additive increase), so a good link ends up with large messages
+ * back to back and a bad one with small, spaced ones.
+ *
+ * Message sizes are in units (retrieval chunks), up to PACER_UNITS_MAX.
+ * This file only depends on <stdint.h> so it also builds on a host.
+ */
+
+#define PACER_UNITS_MAX     8   // Largest message, in units
+#define PACER_GAP_START_MS  50  // Pause a transfer starts with, the former fixed throttle
+#define PACER_GAP_STEP_MS   10  // Additive step of the pause
+#define PACER_GAP_MAX_MS    1000
+#define PACER_SLOW_FACTOR   2   // A message this many times slower than usual counts as congestion
+
+typedef struct {
+    uint8_t units;         // Units in the next message
+    uint16_t gap_ms;       // Pause after each message
+    uint32_t us_per_kb;    // Smoothed send time of 1 KB, 0 until the first message
+    uint32_t increases;    // Statistics
+    uint32_t decreases;
+} Pacer;
+
+void pacer_reset(Pacer &pacer);
+
+// After each message: ok false if it failed, bytes sent and the time it took (us)
+void pacer_update(Pacer &pacer, bool ok, uint32_t bytes, uint32_t send_us);
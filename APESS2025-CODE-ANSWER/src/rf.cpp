@@ -1,10 +1,39 @@
 #include "rf.hpp"
 #include <SPI.h>
 #include "logging.hpp"
+#include "spsc_queue.hpp"
 
 RF24 radio(9, 8);
 
 bool node_online[NUM_NODES + 1] = {false}; // Default all to offline
+static uint8_t rf_seq = 0;
+
+// ACK payloads, see rf_set_ack_payload()
+static RFMessage rf_ack_out;             // Loaded into the radio, reloaded after every use
+static bool rf_ack_out_set = false;
+static RFMessage rf_ack_in;              // Came back with the last rf_send()
+static bool rf_ack_in_valid = false;
+
+static uint8_t rf_retries = 0;
+static bool rf_strong = false;
+
+static SpscQueue<RFMessage, RF_DEFER_QUEUE_SIZE> rf_deferred; // Both ends in loop(), see rf_defer()
+
+#ifdef RF_IRQ_RECEIVE
+static volatile bool rf_irq_pending = true; // The IRQ line may already be low before the interrupt is attached
+static SpscQueue<RFMessage, RF_RX_QUEUE_SIZE> rf_rx_queue;
+
+// Only flags the event: the radio shares the SPI bus with the SD card, so its FIFO is read from loop()
+static void rf_irq_handler()
+{
+    rf_irq_pending = true;
+}
+#endif
+
+uint8_t rf_next_seq()
+{
+    return ++rf_seq;
+}
 
 String rf_format_address(uint16_t node_id)
 {
@@ -34,10 +63,23 @@ bool rf_init()
     radio.setRetries(5, 15);
     radio.enableDynamicPayloads();
     radio.setCRCLength(RF24_CRC_16);
+    radio.enableDynamicAck(); // Lets broadcasts go out without ACK, see rf_command()
+    radio.enableAckPayload(); // Both ends need it, leaf nodes return their status in ACKs
 
     // Set RX address to this node's own ID so it can receive messages addressed to itself
     rf_set_rx_address(NODE_ID);
-    radio.startListening();
+#ifdef LEAFNODE
+    // Pipes 2-5 share the upper address bytes of pipe 1, only the last byte differs
+    radio.openReadingPipe(2, RF_PIPE_BASE | RF_BROADCAST_ID);
+#endif
+
+#ifdef RF_IRQ_RECEIVE
+    // Only RX_DR pulls the IRQ line; TX results are still polled by radio.write()
+    radio.maskIRQ(true, true, false);
+    pinMode(RF_IRQ_PIN, INPUT_PULLUP);
+    attachInterrupt(digitalPinToInterrupt(RF_IRQ_PIN), rf_irq_handler, FALLING);
+#endif
+    rf_start_listening();
 
     Serial.print("[INIT] <RF> Initialized. Listening on ");
     Serial.println(rf_format_address(NODE_ID));
@@ -45,28 +87,159 @@ bool rf_init()
 }
 
 void rf_stop_listening() { radio.stopListening(); }
-void rf_start_listening() { radio.startListening(); }
+// The TX FIFO of a listening radio holds the ACK payloads; one is kept in it
+static void rf_load_ack_payload()
+{
+    if (!rf_ack_out_set)
+        return;
+    radio.flush_tx();
+    radio.writeAckPayload(1, &rf_ack_out, RF_HEADER_SIZE + rf_ack_out.length);
+}
+
+void rf_set_ack_payload(const RFMessage &msg)
+{
+    rf_ack_out = msg;
+    rf_ack_out_set = true;
+    rf_load_ack_payload();
+}
 
-bool rf_send(uint8_t to_id, const RFMessage &msg, bool require_ack)
+bool rf_ack_payload(RFMessage &msg)
+{
+    if (!rf_ack_in_valid)
+        return false;
+    msg = rf_ack_in;
+    return true;
+}
+
+void rf_defer(const RFMessage &msg)
+{
+    if (!rf_deferred.push(msg))
+        Serial.println("[RF] Deferred queue full, message dropped.");
+}
+
+bool rf_take_deferred(RFMessage &msg)
+{
+    return rf_deferred.pop(msg);
+}
+
+uint8_t rf_last_retries() { return rf_retries; }
+bool rf_signal_strong() { return rf_strong; }
+
+void rf_start_listening()
+{
+    radio.startListening();
+    rf_load_ack_payload(); // stopListening() flushed it
+#ifdef RF_IRQ_RECEIVE
+    // Switching modes clears the status flags, a message already in the RX FIFO would not raise the IRQ again
+    rf_irq_pending = true;
+#endif
+}
+
+static bool rf_read(RFMessage &msg);
+
+bool rf_send(uint8_t to_id, const RFMessage &msg, bool multicast)
 {
     uint64_t tx_address = RF_PIPE_BASE | to_id;
     radio.openWritingPipe(tx_address);
-    return radio.write(&msg, sizeof(RFMessage), require_ack);
+
+    // An ACK payload lands in the RX FIFO; only taken if nothing else is waiting there
+    bool fifo_empty = !radio.available();
+    bool sent = radio.write(&msg, RF_HEADER_SIZE + msg.length, multicast); // Header and used payload only
+    rf_retries = radio.getARC();
+
+    rf_ack_in_valid = sent && !multicast && fifo_empty && rf_read(rf_ack_in) && rf_ack_in.from_id == to_id;
+    return sent;
+}
+
+// One message from the RX FIFO; false if it is empty or held a corrupt or foreign message
+static bool rf_read(RFMessage &msg)
+{
+    if (!radio.available())
+        return false;
+
+    uint8_t size = radio.getDynamicPayloadSize(); // 0 if corrupt, the RX FIFO is flushed then
+    if (size == 0)
+        return false;
+    rf_strong = radio.testRPD();
+    radio.read(&msg, size);
+
+    if (size < RF_HEADER_SIZE || msg.version != RF_MSG_VERSION)
+    {
+        Serial.println("[RF] Ignoring message of another protocol version.");
+        return false;
+    }
+    msg.length = size - RF_HEADER_SIZE;
+    return true;
+}
+
+void rf_open_writing(uint8_t to_id)
+{
+    radio.openWritingPipe(RF_PIPE_BASE | to_id);
+}
+
+bool rf_write_fast(const uint8_t *buf, uint8_t len)
+{
+    return radio.writeFast(buf, len);
+}
+
+bool rf_tx_standby(uint32_t timeout_ms)
+{
+    return radio.txStandBy(timeout_ms);
+}
+
+uint8_t rf_read_raw(uint8_t *buf)
+{
+    if (!radio.available())
+        return 0;
+    uint8_t size = radio.getDynamicPayloadSize(); // 0 if corrupt, the RX FIFO is flushed then
+    if (size)
+        radio.read(buf, size);
+    return size;
+}
+
+#ifdef RF_IRQ_RECEIVE
+void rf_service()
+{
+    if (!rf_irq_pending)
+        return;
+    rf_irq_pending = false; // Cleared first: a message arriving while draining raises it again
+
+    bool tx_ok, tx_fail, rx_ready;
+    radio.whatHappened(tx_ok, tx_fail, rx_ready); // Releases the IRQ line
+
+    RFMessage msg;
+    while (radio.available())
+    {
+        if (rf_read(msg) && !rf_rx_queue.push(msg))
+            Serial.println("[RF] RX queue full, message dropped.");
+    }
 }
 
 bool rf_receive(RFMessage &msg, unsigned long timeout_ms)
 {
     unsigned long start_time = millis();
-    while (millis() - start_time < timeout_ms)
+    do
     {
-        if (radio.available())
-        {
-            radio.read(&msg, sizeof(RFMessage));
+        rf_service();
+        if (rf_rx_queue.pop(msg))
             return true;
-        }
-    }
+    } while (millis() - start_time < timeout_ms);
     return false;
 }
+#else
+void rf_service() {}
+
+bool rf_receive(RFMessage &msg, unsigned long timeout_ms)
+{
+    unsigned long start_time = millis();
+    do
+    {
+        if (rf_read(msg))
+            return true;
+    } while (millis() - start_time < timeout_ms);
+    return false;
+}
+#endif
 
 bool rf_send_then_receive(const RFMessage &msg, uint8_t to_id, unsigned long timeout_ms, uint8_t retries)
 {
@@ -282,11 +455,7 @@ void rf_check_node_status()
             continue;
 
         // Prepare LOG message
-        RFMessage msg;
-        msg.from_id = NODE_ID;
-        msg.to_id = node_id;
-        snprintf(msg.payload, sizeof(msg.payload), "LOG %d", log_number);
-        msg.timestamp_ms = millis();
+        RFMessage msg = rf_message(node_id, RFLogNumber{log_number});
 
         rf_stop_listening();
         rf_send(node_id, msg, false);
@@ -300,17 +469,16 @@ void rf_check_node_status()
         // Wait for PONG reply with confirmation
         bool online = false;
         RFMessage reply;
+        RFPong pong;
         if (rf_receive(reply, timeout_ms) &&
             reply.to_id == NODE_ID &&
             reply.from_id == node_id &&
-            strncmp(reply.payload, "PONG", 4) == 0)
+            rf_msg_decode(reply, pong))
         {
-            int confirmed_log = 0;
-            sscanf(reply.payload, "PONG %d", &confirmed_log);
             Serial.print("  - Node ");
             Serial.print(node_id);
             Serial.print(" is ONLINE. Confirmed LOG_NUMBER = ");
-            Serial.println(confirmed_log);
+            Serial.println(pong.log_number);
             online = true;
         }
         else
@@ -331,24 +499,19 @@ void rf_check_node_status()
     while (true)
     {
         RFMessage msg;
+        RFLogNumber received;
         if (rf_receive(msg, 100))
         {
-            if (strncmp(msg.payload, "LOG", 3) == 0 && msg.to_id == NODE_ID)
+            if (msg.to_id == NODE_ID && rf_msg_decode(msg, received))
             {
-                int received_log = 0;
-                sscanf(msg.payload, "LOG %d", &received_log);
-                log_number = received_log;
+                log_number = received.log_number;
                 save_log_number();
 
                 Serial.print("[LEAFNODE] Received and saved LOG_NUMBER = ");
                 Serial.println(log_number);
 
                 // Respond with PONG and confirmed log number
-                RFMessage reply;
-                reply.from_id = NODE_ID;
-                reply.to_id = msg.from_id;
-                snprintf(reply.payload, sizeof(reply.payload), "PONG %d", log_number);
-                reply.timestamp_ms = millis();
+                RFMessage reply = rf_message(msg.from_id, RFPong{log_number});
 
                 rf_stop_listening();
                 rf_send(msg.from_id, reply, false);
@@ -2,23 +2,53 @@
 #include <Arduino.h>
 #include <RF24.h>
 #include "config.hpp"
+#include "rf_msg.hpp"
 
 #define RF_CHANNEL 108
 #define RF_PIPE_BASE 0xF0F0F0F000LL
-
-struct RFMessage
-{
-    uint8_t from_id;
-    uint8_t to_id;
-    char payload[22];       
-    uint64_t timestamp_ms; 
-};
+#define RF_GATEWAY_ID 100
+#define RF_BROADCAST_ID 0xFF // Leaf nodes also listen on this address (pipe 2), for commands to all of them
+#define RF_IRQ_PIN 3         // nRF24L01 IRQ (active low), with RF_IRQ_RECEIVE
+#define RF_RX_QUEUE_SIZE 8   // Received messages held until the state machine takes them, power of two
+#define RF_DEFER_QUEUE_SIZE 4 // Messages set aside by rf_defer(), power of two
 
 extern bool node_online[NUM_NODES + 1]; 
 
+uint8_t rf_next_seq();
+
+// A message of type T from this node to to_id, see rf_msg.hpp
+template <typename T>
+RFMessage rf_message(uint8_t to_id, const T &fields)
+{
+    RFMessage msg;
+    msg.version = RF_MSG_VERSION;
+    msg.from_id = NODE_ID;
+    msg.to_id = to_id;
+    msg.seq = rf_next_seq();
+    rf_msg_encode(msg, fields);
+    return msg;
+}
+
 bool rf_init();
-bool rf_send(uint8_t to_id, const RFMessage &msg, bool require_ack = false);
-bool rf_receive(RFMessage &msg, unsigned long timeout_ms);
+bool rf_send(uint8_t to_id, const RFMessage &msg, bool multicast = false); // multicast: no ACK requested, sent once
+bool rf_receive(RFMessage &msg, unsigned long timeout_ms); // timeout_ms 0: only what has already arrived
+void rf_service();                                         // Move arrived messages into the RX queue (RF_IRQ_RECEIVE)
+void rf_set_ack_payload(const RFMessage &msg); // Returned in the radio ACK of every message received on the node's own pipe
+bool rf_ack_payload(RFMessage &msg);            // ACK payload that came back with the last successful rf_send(), if any
+uint8_t rf_last_retries();                      // Retransmissions the last rf_send() needed
+bool rf_signal_strong();                        // Last message was received above -64 dBm
+
+// An exchange waiting for its replies sets aside the messages meant for the IDLE handlers (e.g. an RFEvent
+// arriving during a broadcast); those handlers take them back before anything received later
+void rf_defer(const RFMessage &msg);
+bool rf_take_deferred(RFMessage &msg);          // Oldest message set aside, false if none
+
+// Raw payloads for bulk transfers (rf_bulk.hpp), outside the RFMessage format
+void rf_open_writing(uint8_t to_id);                 // Destination of rf_write_fast()
+bool rf_write_fast(const uint8_t *buf, uint8_t len); // Queue in the TX FIFO without waiting; false on a lost payload
+bool rf_tx_standby(uint32_t timeout_ms);             // Wait until the TX FIFO is sent; false (FIFO flushed) on timeout
+uint8_t rf_read_raw(uint8_t *buf);                   // One payload from the RX FIFO, its length; 0 if none
+
 bool rf_send_then_receive(const RFMessage &msg, uint8_t to_id, unsigned long timeout_ms, uint8_t retries);
 
 void rf_stop_listening();
@@ -0,0 +1,317 @@
+#include "rf_bulk.hpp"
+#include "crc32.hpp"
+#include "sdcard.hpp"
+#include "sample_format.hpp"
+#include "mqtt.hpp"
+
+// Bytes of a block of a file of `bytes` bytes, the last one may be short
+static uint32_t rf_bulk_block_len(uint32_t block, uint32_t bytes)
+{
+    return min(bytes - block * RF_BULK_BLOCK_SIZE, (uint32_t)RF_BULK_BLOCK_SIZE);
+}
+
+// Slices of a block of len bytes and its CRC
+static uint8_t rf_bulk_slices(uint32_t len)
+{
+    return (len + 4 + RF_BULK_SLICE_DATA - 1) / RF_BULK_SLICE_DATA;
+}
+
+static uint8_t rf_bulk_slice_len(uint32_t len, uint8_t slice)
+{
+    return min(len + 4 - slice * RF_BULK_SLICE_DATA, (uint32_t)RF_BULK_SLICE_DATA);
+}
+
+#ifdef GATEWAY
+static uint8_t rf_bulk_window[RF_BULK_WINDOW][RF_BULK_BLOCK_SIZE + 4]; // Block bytes, then their CRC
+
+static bool rf_bulk_send(const RFMessage &msg)
+{
+    rf_stop_listening();
+    bool sent = rf_send(msg.to_id, msg);
+    rf_start_listening();
+    return sent;
+}
+
+// The leaf node's RFBulkInfo for log_number, asked up to RF_BULK_STALLS_MAX times
+static bool rf_bulk_get_info(uint8_t node_id, uint16_t log_number, RFBulkInfo &info)
+{
+    RFMessage get = rf_message(node_id, RFBulkGet{log_number});
+    for (uint8_t attempt = 0; attempt < RF_BULK_STALLS_MAX; ++attempt)
+    {
+        if (!rf_bulk_send(get))
+            continue;
+
+        RFMessage reply;
+        unsigned long start_time = millis();
+        unsigned long elapsed;
+        while ((elapsed = millis() - start_time) < RF_BULK_REPLY_MS)
+        {
+            if (!rf_receive(reply, RF_BULK_REPLY_MS - elapsed))
+                break;
+            if (reply.to_id == NODE_ID && reply.type == (uint8_t)RFMsgType::EVENT)
+                rf_defer(reply); // For rf_poll_events()
+            else if (reply.to_id == NODE_ID && reply.from_id == node_id && rf_msg_decode(reply, info) &&
+                info.log_number == log_number)
+                return true;
+        }
+    }
+    return false;
+}
+
+// Slices of the wanted blocks of the window at first_block, until they are all in or the leaf node falls
+// silent; got[] holds the slices of each block received so far. Returns the blocks still wanted.
+static uint8_t rf_bulk_receive(uint32_t first_block, uint8_t wanted, const RFBulkInfo &info, uint32_t got[RF_BULK_WINDOW])
+{
+    unsigned long last_ms = millis();
+    unsigned long wait_ms = RF_BULK_REPLY_MS;
+    while (wanted && millis() - last_ms < wait_ms)
+    {
+        uint8_t slice[RF_MSG_SIZE];
+        uint8_t size = rf_read_raw(slice);
+        if (size >= RF_HEADER_SIZE && slice[0] == RF_MSG_VERSION && slice[1] == (uint8_t)RFMsgType::EVENT)
+        {
+            // An event notification of a leaf node, for rf_poll_events()
+            RFMessage event;
+            memcpy(&event, slice, size);
+            event.length = size - RF_HEADER_SIZE;
+            rf_defer(event);
+            continue;
+        }
+        if (size <= 2 || slice[0] != RF_BULK_TAG)
+            continue;
+        last_ms = millis();
+        wait_ms = RF_BULK_IDLE_MS;
+
+        uint8_t slot = slice[1] >> 5;
+        uint8_t index = slice[1] & 0x1F;
+        if (slot >= RF_BULK_WINDOW || !(wanted & (1 << slot)))
+            continue; // Resent after it was complete
+
+        uint32_t len = rf_bulk_block_len(first_block + slot, info.bytes);
+        uint8_t slices = rf_bulk_slices(len);
+        if (index >= slices || size - 2 != rf_bulk_slice_len(len, index))
+            continue;
+        memcpy(rf_bulk_window[slot] + index * RF_BULK_SLICE_DATA, slice + 2, size - 2);
+        got[slot] |= 1UL << index;
+
+        if (got[slot] == (1UL << slices) - 1)
+        {
+            uint32_t crc;
+            rf_msg_get(rf_bulk_window[slot] + len, crc);
+            if (crc == crc32(rf_bulk_window[slot], len))
+                wanted &= ~(1 << slot);
+            else
+                got[slot] = 0; // Asked for whole again
+        }
+    }
+    return wanted;
+}
+
+// One block as "<name>[<block>/<blocks>@<offset>#<crc>]:" and its bytes, like sensing_send_chunks()
+static bool rf_bulk_relay(const char *prefix, uint32_t block, const RFBulkInfo &info)
+{
+    const uint8_t *data = rf_bulk_window[block % RF_BULK_WINDOW];
+    uint32_t len = rf_bulk_block_len(block, info.bytes);
+    uint32_t crc;
+    rf_msg_get(data + len, crc);
+
+    char header[96];
+    uint32_t header_len = snprintf(header, sizeof(header), "%s[%lu/%lu@%lu#%08lX]:", prefix,
+                                   (unsigned long)block + 1, (unsigned long)info.blocks,
+                                   (unsigned long)block * RF_BULK_BLOCK_SIZE, (unsigned long)crc);
+
+    if (!mqtt_client.beginPublish(MQTT_TOPIC_PUB, header_len + len, false))
+        return false;
+    if (mqtt_client.write(reinterpret_cast<const uint8_t *>(header), header_len) != header_len ||
+        mqtt_client.write(data, len) != len)
+    {
+        // Part of a message is on the wire; only a new session gets the broker back in step
+        mqtt_client.disconnect();
+        return false;
+    }
+    return mqtt_client.endPublish();
+}
+
+bool rf_bulk_pull(uint8_t node_id, uint16_t log_number)
+{
+    char prefix[20];
+    snprintf(prefix, sizeof(prefix), "N%03u_%03u" SAMPLE_FILE_EXT, node_id, log_number);
+    Serial.print("[GATEWAY] Pulling ");
+    Serial.print(prefix);
+    Serial.println(" over RF...");
+
+    RFBulkInfo info = {log_number, 0, 0};
+    bool answered = rf_bulk_get_info(node_id, log_number, info);
+    if (!answered || info.blocks == 0)
+    {
+        char missing_msg[48];
+        snprintf(missing_msg, sizeof(missing_msg), "%s[%s]", prefix, answered ? "not found" : "no answer");
+        mqtt_client.publish(MQTT_TOPIC_PUB, missing_msg);
+        Serial.print("[GATEWAY] ");
+        Serial.println(missing_msg);
+        return false;
+    }
+
+    unsigned long start_ms = millis();
+    uint32_t relayed = 0;
+    uint32_t bytes_relayed = 0;
+    uint32_t requests = 0;
+    for (uint32_t first = 0; first < info.blocks; first += RF_BULK_WINDOW)
+    {
+        uint8_t count = min(info.blocks - first, (uint32_t)RF_BULK_WINDOW);
+        uint8_t wanted = (1 << count) - 1;
+        uint32_t got[RF_BULK_WINDOW] = {0};
+
+        // Selective repeat: each request names only the blocks still missing
+        for (uint8_t stalls = 0; wanted && stalls < RF_BULK_STALLS_MAX;)
+        {
+            RFMessage want = rf_message(node_id, RFBulkWant{first, wanted});
+            uint8_t left = rf_bulk_send(want) ? rf_bulk_receive(first, wanted, info, got) : wanted;
+            stalls = left == wanted ? stalls + 1 : 0;
+            wanted = left;
+            requests++;
+        }
+        if (wanted)
+            break;
+
+        bool ok = true;
+        for (uint8_t slot = 0; ok && slot < count; ++slot)
+        {
+            if (!(ok = rf_bulk_relay(prefix, first + slot, info)))
+            {
+                mqtt_loop(); // Reconnects if the broker dropped us
+                ok = rf_bulk_relay(prefix, first + slot, info);
+            }
+            if (ok)
+            {
+                relayed++;
+                bytes_relayed += rf_bulk_block_len(first + slot, info.bytes);
+            }
+        }
+        if (!ok)
+            break;
+        mqtt_loop(); // keep MQTT alive
+    }
+
+    // Ends the session; the leaf node would otherwise wait RF_BULK_SESSION_MS for the next request
+    rf_bulk_send(rf_message(node_id, RFBulkWant{info.blocks, 0}));
+
+    uint32_t elapsed_ms = millis() - start_ms;
+    uint32_t throughput = elapsed_ms ? (uint64_t)bytes_relayed * 1000 / elapsed_ms : 0;
+    char done_msg[80];
+    snprintf(done_msg, sizeof(done_msg), "%s[done %lu/%lu %lu B/s]", prefix,
+             (unsigned long)relayed, (unsigned long)info.blocks, (unsigned long)throughput);
+    mqtt_client.publish(MQTT_TOPIC_PUB, done_msg);
+
+    Serial.print("[GATEWAY] ");
+    Serial.print(done_msg);
+    Serial.print(", ");
+    Serial.print(requests);
+    Serial.println(" window requests.");
+    return relayed == info.blocks;
+}
+#endif
+
+#ifdef LEAFNODE
+static uint8_t rf_bulk_block[RF_BULK_BLOCK_SIZE + 4]; // Block bytes, then their CRC
+
+static void rf_bulk_send_info(uint8_t to_id, const RFBulkInfo &info)
+{
+    RFMessage reply = rf_message(to_id, info);
+    rf_stop_listening();
+    rf_send(to_id, reply);
+    rf_start_listening();
+}
+
+// The wanted blocks of a window; the slices of a block are queued back to back
+static void rf_bulk_send_window(File &file, uint8_t to_id, const RFBulkWant &want, const RFBulkInfo &info)
+{
+    rf_stop_listening();
+    rf_open_writing(to_id);
+    for (uint8_t slot = 0; slot < RF_BULK_WINDOW; ++slot)
+    {
+        uint32_t block = want.first_block + slot;
+        if (!(want.blocks & (1 << slot)) || block >= info.blocks)
+            continue;
+
+        uint32_t len = rf_bulk_block_len(block, info.bytes);
+        if (!file.seek(block * RF_BULK_BLOCK_SIZE) || file.read(rf_bulk_block, len) != (int)len)
+            continue; // The gateway asks again
+        rf_msg_put(rf_bulk_block + len, crc32(rf_bulk_block, len));
+
+        bool ok = true;
+        uint8_t slices = rf_bulk_slices(len);
+        for (uint8_t index = 0; ok && index < slices; ++index)
+        {
+            uint8_t slice[RF_MSG_SIZE];
+            uint8_t n = rf_bulk_slice_len(len, index);
+            slice[0] = RF_BULK_TAG;
+            slice[1] = (slot << 5) | index;
+            memcpy(slice + 2, rf_bulk_block + index * RF_BULK_SLICE_DATA, n);
+            ok = rf_write_fast(slice, n + 2);
+        }
+
+        // After a lost slice the rest of the block is flushed, the gateway asks for it again
+        rf_tx_standby(ok ? RF_BULK_STANDBY_MS : 0);
+    }
+    rf_start_listening();
+}
+
+void rf_bulk_serve(const RFMessage &request)
+{
+    RFBulkGet get;
+    if (!rf_msg_decode(request, get))
+        return;
+
+    char name[20];
+    snprintf(name, sizeof(name), "/N%03d_%03u" SAMPLE_FILE_EXT, NODE_ID, get.log_number);
+    File file = SD.open(name, FILE_READ);
+
+    RFBulkInfo info = {get.log_number, 0, 0};
+    if (file)
+    {
+        info.bytes = file.size();
+        info.blocks = (info.bytes + RF_BULK_BLOCK_SIZE - 1) / RF_BULK_BLOCK_SIZE;
+    }
+    rf_bulk_send_info(request.from_id, info);
+
+    Serial.print("[LEAFNODE] Bulk transfer of ");
+    Serial.print(name);
+    Serial.print(": ");
+    Serial.print(info.blocks);
+    Serial.println(" blocks.");
+    if (info.blocks == 0)
+    {
+        if (file)
+            file.close();
+        return;
+    }
+
+    // Served until the gateway ends the session or falls silent
+    unsigned long last_ms = millis();
+    while (millis() - last_ms < RF_BULK_SESSION_MS)
+    {
+        RFMessage msg;
+        RFBulkGet again;
+        RFBulkWant want;
+        if (!rf_receive(msg, 10) || msg.to_id != NODE_ID || msg.from_id != request.from_id)
+            continue;
+
+        if (rf_msg_decode(msg, again) && again.log_number == get.log_number)
+        {
+            last_ms = millis();
+            rf_bulk_send_info(request.from_id, info); // The first answer was lost
+            continue;
+        }
+        if (!rf_msg_decode(msg, want))
+            continue;
+
+        last_ms = millis();
+        if (want.blocks == 0)
+            break;
+        rf_bulk_send_window(file, request.from_id, want, info);
+    }
+    file.close();
+    Serial.println("[LEAFNODE] Bulk transfer ended.");
+}
+#endif
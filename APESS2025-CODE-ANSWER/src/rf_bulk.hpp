@@ -0,0 +1,50 @@
+#pragma once
+#include <Arduino.h>
+#include "config.hpp"
+#include "rf.hpp"
+
+/*
+ * RF bulk transfer
+ *
+ * Pulls a sample log from a leaf node to the gateway over the radio, which
+ * relays it to MQTT in the same "<name>[i/n@offset#crc]:" messages as
+ * sensing_retrieve_file().
+ *
+ * The file is sent in 512-byte blocks, each followed by its CRC-32 and cut
+ * into 30-byte slices. A slice is one raw payload: a tag byte, then the
+ * block's slot in the window (3 bits) and the slice index (5 bits), then the
+ * data - 2 bytes of overhead per 32-byte payload. The leaf node queues the
+ * slices with writeFast(), so the radio sends them back to back with
+ * hardware ACK and retries, and only waits with txStandBy() at the end of a
+ * block.
+ *
+ * 1. The gateway sends RFBulkGet{log_number}; the leaf node answers
+ *    RFBulkInfo with the block count and size of the file (0 blocks: not
+ *    found). Integrity is checked per block, with the CRC-32 sent after it.
+ * 2. The gateway sends RFBulkWant{first_block, blocks}: the bitmap of the
+ *    blocks of the window starting at first_block it still needs. The leaf
+ *    node sends exactly those.
+ * 3. Blocks that arrive whole with a good CRC are cleared from the bitmap,
+ *    the rest are asked for again (selective repeat). A complete window is
+ *    relayed to MQTT and the next one requested.
+ * 4. RFBulkWant with an empty bitmap ends the session.
+ */
+
+#define RF_BULK_TAG         0xB5 // First byte of a slice; never an RF_MSG_VERSION
+#define RF_BULK_BLOCK_SIZE  512
+#define RF_BULK_SLICE_DATA  (RF_MSG_SIZE - 2)
+#define RF_BULK_WINDOW      4    // Blocks per window, at most 8 (RFBulkWant bitmap); the gateway buffers them all
+#define RF_BULK_REPLY_MS    300  // Wait for the first slice or message of an answer
+#define RF_BULK_IDLE_MS     50   // Silence that ends a window
+#define RF_BULK_STANDBY_MS  100  // Leaf node: wait for the last slices of a block
+#define RF_BULK_STALLS_MAX  5    // Requests of a window without progress before the gateway gives up
+#define RF_BULK_SESSION_MS  3000 // Leaf node: gateway silence that ends a session
+
+static_assert(RF_BULK_WINDOW <= 8, "RFBulkWant holds one bit per block of a window");
+static_assert((RF_BULK_BLOCK_SIZE + 4 + RF_BULK_SLICE_DATA - 1) / RF_BULK_SLICE_DATA < 32, "Slice index has 5 bits");
+
+// For GATEWAY
+bool rf_bulk_pull(uint8_t node_id, uint16_t log_number); // Relay the leaf node's log to MQTT; false if it did not complete
+
+// For LEAFNODE
+void rf_bulk_serve(const RFMessage &request);            // Answer an RFBulkGet until the gateway ends the session
@@ -1,133 +1,354 @@
 #include "rf_cmd.hpp"
+#include "logging.hpp"
+#include "sdcard.hpp"
+#include "rf_bulk.hpp"
 
-void rf_command(const char *cmd)
+RFNodeStatus rf_node_status[NUM_NODES + 1];
+
+// Keep the status a leaf node returned in the ACK of the last rf_send(); false if none came back
+static bool rf_store_ack_status()
 {
-    RFMessage msg;
-    msg.from_id = NODE_ID;
-    strncpy(msg.payload, cmd, sizeof(msg.payload));
+    RFMessage reply;
+    RFStatus status;
+    if (!rf_ack_payload(reply) || reply.from_id < 1 || reply.from_id > NUM_NODES || !rf_msg_decode(reply, status))
+        return false;
 
-    for (uint8_t target_id = 1; target_id <= NUM_NODES; ++target_id)
+    rf_node_status[reply.from_id].status = status;
+    rf_node_status[reply.from_id].received_ms = millis();
+    rf_node_status[reply.from_id].valid = true;
+    return true;
+}
+
+// Confirmations of broadcast seq from leaf nodes, until the window closes; returns how many arrived
+static uint8_t rf_collect_confirms(uint8_t seq, bool confirmed[NUM_NODES + 1])
+{
+    uint8_t count = 0;
+    unsigned long start_time = millis();
+    unsigned long elapsed;
+    while ((elapsed = millis() - start_time) < RF_CONFIRM_WINDOW_MS)
     {
-        msg.to_id = target_id;
+        RFMessage reply;
+        RFConfirm confirm;
+        if (!rf_receive(reply, RF_CONFIRM_WINDOW_MS - elapsed))
+            break;
+        if (reply.to_id == NODE_ID && reply.type == (uint8_t)RFMsgType::EVENT)
+        {
+            rf_defer(reply); // Sent once by the leaf node, rf_poll_events() publishes it
+            continue;
+        }
+        if (reply.to_id != NODE_ID || !rf_msg_decode(reply, confirm) || confirm.seq != seq ||
+            reply.from_id < 1 || reply.from_id > NUM_NODES || confirmed[reply.from_id])
+            continue;
+        confirmed[reply.from_id] = true;
+        count++;
+    }
+    return count;
+}
 
-        Serial.print("[GATEWAY] Sending RF Command to Node ");
-        Serial.print(target_id);
-        Serial.print(": ");
-        Serial.println(msg.payload);
+// One no-ACK broadcast, then unicast with hardware ACK only to the leaf nodes that did not confirm it
+static uint8_t rf_command_fanout(RFMessage msg, uint8_t unicast_rounds)
+{
+    bool confirmed[NUM_NODES + 1] = {false}; // By node id, leaf nodes are 1..NUM_NODES
+
+    Serial.print("[GATEWAY] Broadcasting RF Command: ");
+    Serial.println(rf_msg_name(msg.type));
+
+    msg.to_id = RF_BROADCAST_ID;
+    rf_stop_listening();
+    rf_send(RF_BROADCAST_ID, msg, true);
+    rf_start_listening();
+
+    uint8_t reached = rf_collect_confirms(msg.seq, confirmed);
+    Serial.print("[GATEWAY] Broadcast confirmed by ");
+    Serial.print(reached);
+    Serial.print("/");
+    Serial.print(NUM_NODES);
+    Serial.println(" nodes.");
+
+    // Same sequence number as the broadcast, a node that got it but whose confirmation was lost drops the repeat
+    for (uint8_t round = 0; round < unicast_rounds && reached < NUM_NODES; ++round)
+    {
+        if (round > 0)
+            delay(RF_CMD_WAIT_MS);
 
         rf_stop_listening();
-        bool success = rf_send(msg.to_id, msg);
-        if (success)
+        for (uint8_t target_id = 1; target_id <= NUM_NODES; ++target_id)
+        {
+            if (confirmed[target_id])
+                continue;
+
+            msg.to_id = target_id;
+            if (rf_send(target_id, msg))
+            {
+                rf_store_ack_status();
+                confirmed[target_id] = true;
+                reached++;
+                Serial.print("[GATEWAY] Command sent to Node ");
+                Serial.println(target_id);
+            }
+        }
+        rf_start_listening();
+    }
+
+    for (uint8_t target_id = 1; target_id <= NUM_NODES; ++target_id)
+    {
+        if (!confirmed[target_id])
+        {
+            Serial.print("[GATEWAY] Failed to send command to Node ");
+            Serial.println(target_id);
+        }
+    }
+    return reached;
+}
+
+uint8_t rf_command(RFMessage msg)
+{
+    return rf_command_fanout(msg, 1);
+}
+
+uint8_t send_command_with_retry(const RFMessage &msg)
+{
+    return rf_command_fanout(msg, RF_CMD_RETRY);
+}
+
+uint8_t rf_poll_status()
+{
+    RFMessage poll = rf_message(0, RFPoll{});
+    uint8_t answered = 0;
+
+    rf_stop_listening();
+    for (uint8_t target_id = 1; target_id <= NUM_NODES; ++target_id)
+    {
+        poll.to_id = target_id;
+        if (rf_send(target_id, poll) && rf_store_ack_status())
+            answered++;
+    }
+    rf_start_listening();
+
+    Serial.print("[GATEWAY] Status received from ");
+    Serial.print(answered);
+    Serial.print("/");
+    Serial.print(NUM_NODES);
+    Serial.println(" nodes.");
+    return answered;
+}
+
+void rf_publish_status()
+{
+    uint8_t known = 0;
+    for (uint8_t node_id = 1; node_id <= NUM_NODES; ++node_id)
+    {
+        const RFNodeStatus &node = rf_node_status[node_id];
+
+        char buf[192];
+        if (!node.valid)
         {
-            Serial.println("[GATEWAY] Command sent successfully.");
+            snprintf(buf, sizeof(buf), "N%03u | no status", node_id);
         }
         else
         {
-            Serial.println("[GATEWAY] Failed to send command.");
+            const RFStatus &status = node.status;
+            char sync[24] = "never synced";
+            if (status.flags & RF_STATUS_TIME_SYNCED)
+                snprintf(sync, sizeof(sync), "synced %lu s ago", (unsigned long)status.since_sync_s);
+
+            snprintf(buf, sizeof(buf), "N%03u | %s | log %d | SD %lu MB free | drift %+ld ppm | %s | up %lu s | %u retries | %s signal | %s%s%lu s old",
+                     node_id, node_state_name((NodeState)status.state), status.log_number,
+                     status.flags & RF_STATUS_SD_READY ? (unsigned long)(status.sd_free_kb / 1024) : 0UL,
+                     (long)status.drift_ppm, sync, (unsigned long)status.uptime_s,
+                     status.tx_retries, status.signal_strong ? "strong" : "weak",
+                     status.flags & RF_STATUS_SENSING_SCHEDULED ? "SCHEDULED | " : "",
+                     status.flags & RF_STATUS_TRIGGER_ARMED ? "TRIGGER | " : "",
+                     (millis() - node.received_ms) / 1000UL);
+            known++;
         }
-        rf_start_listening();
+        mqtt_client.publish(MQTT_TOPIC_PUB, buf);
+        Serial.println(buf);
+
+        mqtt_loop(); // keep MQTT alive
     }
+
+    char buf[48];
+    snprintf(buf, sizeof(buf), "CMD_STATUS: %u/%u nodes.", known, NUM_NODES);
+    mqtt_client.publish(MQTT_TOPIC_PUB, buf);
+    Serial.println("[COMMUNICATION] CMD_STATUS sent.");
 }
 
-void send_command_with_retry(const char *cmd)
+void rf_poll_events()
 {
-    for (int attempt = 0; attempt < RF_CMD_RETRY; ++attempt)
+    RFMessage msg;
+    RFEvent event;
+
+    // Leaf nodes report event logs unsolicited; those set aside during other exchanges first, then only
+    // what has already arrived, so IDLE stays responsive. Anything else here is a late reply to an exchange
+    // that already ended.
+    while (rf_take_deferred(msg) || rf_receive(msg, 0))
     {
-        rf_command(cmd);
-        delay(RF_CMD_WAIT_MS);
+        if (msg.to_id != NODE_ID || !rf_msg_decode(msg, event))
+            continue;
+
+        char buf[64];
+        snprintf(buf, sizeof(buf), "Event recorded: N%03d_%03d", msg.from_id, event.log_number);
+        Serial.print("[GATEWAY] ");
+        Serial.println(buf);
+        mqtt_client.publish(MQTT_TOPIC_PUB, buf);
     }
 }
 
+void rf_notify_event(uint16_t log_no, uint64_t trigger_ms)
+{
+    RFMessage msg = rf_message(RF_GATEWAY_ID, RFEvent{log_no, trigger_ms});
+
+    rf_stop_listening();
+    bool success = rf_send(msg.to_id, msg);
+    rf_start_listening();
+
+    Serial.print("[LEAFNODE] Event notification ");
+    Serial.println(success ? "sent." : "failed.");
+}
+
+// A repeat of the previous message from the same sender, see send_command_with_retry()
+static bool rf_is_repeat(const RFMessage &msg)
+{
+    static uint8_t last_from = 0;
+    static uint8_t last_seq = 0;
+    static unsigned long last_ms = 0;
+
+    bool repeat = msg.from_id == last_from && msg.seq == last_seq && millis() - last_ms < RF_REPEAT_WINDOW_MS;
+    last_from = msg.from_id;
+    last_seq = msg.seq;
+    last_ms = millis();
+    return repeat;
+}
+
+// Status the gateway gets in the radio ACK of its next message to this node
+static void rf_update_status()
+{
+    RFStatus status;
+    status.state = (uint8_t)node_status.get_state();
+    status.flags = (node_status.node_flags.time_rf_synced ? RF_STATUS_TIME_SYNCED : 0) |
+                   (node_status.node_flags.sensing_scheduled ? RF_STATUS_SENSING_SCHEDULED : 0) |
+                   (node_status.node_flags.sd_ready ? RF_STATUS_SD_READY : 0) |
+                   (node_status.node_flags.trigger_armed ? RF_STATUS_TRIGGER_ARMED : 0);
+    status.log_number = log_number;
+    status.sd_free_kb = node_status.node_flags.sd_ready ? sdcard_free_kb() : 0;
+    status.drift_ppm = (int32_t)lroundf((Time.drift_ratio - 1.0f) * 1e6f); // Ratio 1 is no drift
+    status.since_sync_s = (millis() - Time.last_sync_running_time) / 1000;
+    status.uptime_s = millis() / 1000;
+    status.tx_retries = rf_last_retries();
+    status.signal_strong = rf_signal_strong();
+    rf_set_ack_payload(rf_message(RF_GATEWAY_ID, status));
+}
+
 void rf_handle()
 {
     RFMessage msg;
 
-    if (rf_receive(msg, 200)) // 200ms timeout
+    // A received message used up the loaded ACK payload; refreshed periodically so it stays current
+    static unsigned long last_status_ms = 0;
+    static bool status_loaded = false;
+    if (!status_loaded || millis() - last_status_ms >= RF_STATUS_REFRESH_MS)
     {
-        if (msg.to_id != NODE_ID)
+        rf_update_status();
+        last_status_ms = millis();
+        status_loaded = true;
+    }
+
+    if (rf_receive(msg, RF_HANDLE_WAIT_MS))
+    {
+        status_loaded = false;
+
+        if (msg.to_id != NODE_ID && msg.to_id != RF_BROADCAST_ID)
+            return;
+
+        // Broadcasts are not ACKed by the radio; each node answers in its own slot so the confirmations do not collide
+        if (msg.to_id == RF_BROADCAST_ID)
+        {
+            delay((NODE_ID - 1) * RF_CONFIRM_SLOT_MS);
+            RFMessage confirm = rf_message(msg.from_id, RFConfirm{msg.seq});
+            rf_stop_listening();
+            rf_send(confirm.to_id, confirm);
+            rf_start_listening();
+        }
+
+        if (rf_is_repeat(msg))
             return;
 
         Serial.print("[RF_COMMUNICATION] Message received from Node ");
         Serial.print(msg.from_id);
         Serial.print(": ");
-        Serial.println(msg.payload);
+        Serial.println(rf_msg_name(msg.type));
 
-        // === CMD_REBOOT ===
-        if (strcmp(msg.payload, "CMD_REBOOT") == 0)
+        switch ((RFMsgType)msg.type)
         {
+        case RFMsgType::REBOOT:
             Serial.println("[LEAFNODE] Reboot command received.");
             node_status.node_flags.reboot_required_leafnode = true;
             node_status.set_state(NodeState::BOOT);
             rgbled_set_by_state(NodeState::BOOT);
-        }
+            break;
 
-        // === CMD_RF_SYNC ===
-        else if (strcmp(msg.payload, "CMD_RF_SYNC") == 0)
-        {
+        case RFMsgType::RF_SYNC:
             Serial.println("[LEAFNODE] RF Sync command received.");
             node_status.node_flags.time_rf_required = true;
             node_status.set_state(NodeState::RF_COMMUNICATING);
             rgbled_set_by_state(NodeState::RF_COMMUNICATING);
-        }
+            break;
 
-        // === Sensing Schedule Command ===
-        else if (strncmp(msg.payload, "S_", 2) == 0)
+#ifdef SENSING_TRIGGER
+        case RFMsgType::TRIGGER_ON:
         {
-            Serial.println("[LEAFNODE] Sensing command received.");
-
-            // Step 1: Extract 12-digit time
-            char datetime[13] = {0};
-            strncpy(datetime, msg.payload + 2, 12);
-
-            // Step 2: Find first and second underscore after time part
-            const char *ptr = msg.payload + 14;
-            const char *first_underscore = strchr(ptr, '_');
-            if (!first_underscore)
+            RFTriggerOn trigger;
+            if (rf_msg_decode(msg, trigger) && trigger.rate_hz > 0 && trigger.post_s > 0)
             {
-                Serial.println("[LEAFNODE] Invalid sensing command format: missing first underscore.");
-                return;
-            }
+                trigger_rate_hz = trigger.rate_hz;
+                trigger_post_s = trigger.post_s;
+                node_status.node_flags.trigger_armed = true;
 
-            const char *second_underscore = strchr(first_underscore + 1, '_');
-            if (!second_underscore)
+                Serial.print("[LEAFNODE] Event trigger armed: ");
+                Serial.print(trigger_rate_hz);
+                Serial.print(" Hz, ");
+                Serial.print(trigger_post_s);
+                Serial.println(" sec after each event");
+            }
+            else
             {
-                Serial.println("[LEAFNODE] Invalid sensing command format: missing second underscore.");
-                return;
+                Serial.println("[LEAFNODE] Invalid trigger command format.");
             }
+            break;
+        }
 
-            // Step 3: Extract substrings for rate and duration
-            char rate_buf[6] = {0};
-            char dur_buf[6] = {0};
+        case RFMsgType::TRIGGER_OFF:
+            node_status.node_flags.trigger_armed = false;
+            Serial.println("[LEAFNODE] Event trigger disarmed.");
+            break;
+#endif
 
-            size_t rate_len = second_underscore - (first_underscore + 1);
-            size_t dur_len = strlen(second_underscore + 1);
+        case RFMsgType::SCHEDULE:
+        {
+            Serial.println("[LEAFNODE] Sensing command received.");
 
-            if (rate_len >= sizeof(rate_buf) || dur_len >= sizeof(dur_buf))
+            RFSchedule schedule;
+            if (!rf_msg_decode(msg, schedule))
             {
-                Serial.println("[LEAFNODE] Rate or duration value too long.");
-                return;
+                Serial.println("[LEAFNODE] Invalid sensing command format.");
+                break;
             }
 
-            strncpy(rate_buf, first_underscore + 1, rate_len);
-            strncpy(dur_buf, second_underscore + 1, dur_len);
-
-            int rate = atoi(rate_buf);
-            int dur = atoi(dur_buf);
-
-            CalendarTime SensingSchedule;
-            SensingSchedule = YYMMDDHHMMSS2Calendar(datetime);
-
-            parsed_freq = rate;
+            parsed_freq = schedule.rate_hz;
             sensing_rate_hz = parsed_freq;
-            parsed_duration = dur;
+            parsed_duration = schedule.duration_s;
             sensing_duration_s = parsed_duration;
+            sensing_range_g = schedule.range_g;
+            sensing_dlpf_hz = schedule.dlpf_hz; // 0: picked from the rate table
 
-            sensing_scheduled_start_ms = unix_from_calendar_milliseconds(SensingSchedule);
-            sensing_scheduled_end_ms = sensing_scheduled_start_ms + dur * 1000;
+            sensing_scheduled_start_ms = schedule.start_ms;
+            sensing_scheduled_end_ms = sensing_scheduled_start_ms + (uint64_t)schedule.duration_s * 1000;
 
             node_status.node_flags.sensing_scheduled = true; // very important!
 
             // Debug print
+            CalendarTime SensingSchedule = calendar_from_unix_milliseconds(sensing_scheduled_start_ms);
             Serial.print("[LEAFNODE] Parsed Time: ");
             Serial.print(SensingSchedule.year);
             Serial.print("-");
@@ -150,17 +371,25 @@ void rf_handle()
             Serial.print("[LEAFNODE] Scheduled Start Time (ms): ");
             Serial.println(sensing_scheduled_start_ms);
 
-            Serial.print("[LEAFNODE] Scheduled Sampling Rate: ");
-            Serial.print(sensing_rate_hz);
-
-            Serial.print(" Hz, Duration: ");
-            Serial.print(sensing_duration_s);
-            Serial.println(" sec");
+            Serial.print("[LEAFNODE] Sensing profile: +-");
+            Serial.print(sensing_range_g);
+            Serial.print(" g, DLPF ");
+            Serial.print(sensing_dlpf_hz);
+            Serial.println(" Hz (0 = auto)");
+            break;
         }
+
+        case RFMsgType::POLL:
+            break; // Answered by the ACK payload
+
+        case RFMsgType::BULK_GET:
+            rf_bulk_serve(msg);
+            break;
+
         // === Unknown Command ===
-        else
-        {
+        default:
             Serial.println("[RF_COMMUNICATION] Unknown command.");
+            break;
         }
     }
 }
@@ -10,11 +10,40 @@
 
 #define RF_CMD_RETRY        3     
 #define RF_CMD_WAIT_MS      100   
+#define RF_CONFIRM_SLOT_MS  5     // Leaf node n confirms a broadcast (n - 1) slots after receiving it
+#define RF_CONFIRM_WINDOW_MS (NUM_NODES * RF_CONFIRM_SLOT_MS + 20) // Gateway wait for the confirmations
+#define RF_REPEAT_WINDOW_MS 2000  // A message with the sequence number of the previous one within this time is a repeat
+
+#define RF_STATUS_REFRESH_MS 1000 // Leaf nodes rebuild the status in their ACK payload this often
+
+// RFStatus flags
+#define RF_STATUS_TIME_SYNCED       0x01
+#define RF_STATUS_SENSING_SCHEDULED 0x02
+#define RF_STATUS_SD_READY          0x04
+#define RF_STATUS_TRIGGER_ARMED     0x08
+
+#ifdef RF_IRQ_RECEIVE
+#define RF_HANDLE_WAIT_MS   0     // Messages wait in the RX queue, IDLE never blocks on the radio
+#else
+#define RF_HANDLE_WAIT_MS   200   // Polled: wait for a message to arrive
+#endif
 
 // For GATEWAY
-void rf_command(const char *cmd);
-void send_command_with_retry(const char *cmd);
+uint8_t rf_command(RFMessage msg);                     // Broadcast to every leaf node, unicast to those not confirming; returns nodes reached
+uint8_t send_command_with_retry(const RFMessage &msg); // rf_command() with RF_CMD_RETRY unicast rounds, leaf nodes drop the repeats
+void rf_poll_events();                                    // Publish event notifications from leaf nodes
+uint8_t rf_poll_status();                                 // Poll every leaf node, the statuses come back in the ACKs; returns nodes answering
+void rf_publish_status();                                 // One MQTT message per leaf node, from rf_node_status
+
+typedef struct {
+    RFStatus status;           // Last one received, in the ACK of a poll or command
+    unsigned long received_ms; // millis() when it arrived
+    bool valid;
+} RFNodeStatus;
+
+extern RFNodeStatus rf_node_status[NUM_NODES + 1]; // By node id
 
 // For LEAFNODE
 void rf_handle();
+void rf_notify_event(uint16_t log_no, uint64_t trigger_ms); // Report an event log to the gateway
 
@@ -0,0 +1,168 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * RF message codec
+ *
+ * Every RF message is one nRF24L01 payload: a 5-byte header (protocol
+ * version, message type, sender, receiver, sequence number) followed by the
+ * fields of its type, packed little-endian. Only header + fields go over the
+ * air; the radio's dynamic payload length tells the receiver how many bytes
+ * arrived.
+ *
+ * All message types are listed once in RF_MESSAGES below. The type enum, the
+ * field structs, the wire sizes and the encode / decode functions are all
+ * generated from it, so gateway and leaf nodes cannot disagree on a layout.
+ * Adding a type or a field is one line here; changing a layout in a way old
+ * nodes cannot read means bumping RF_MSG_VERSION.
+ *
+ * This file only depends on <stdint.h> so it also builds on a host.
+ */
+
+// Not a valid node id: payloads of the former ASCII format, which started with from_id, never pass as this version
+#define RF_MSG_VERSION 0xA2
+
+#define RF_MSG_SIZE    32 // nRF24L01 payload limit
+#define RF_HEADER_SIZE 5
+#define RF_PAYLOAD_SIZE (RF_MSG_SIZE - RF_HEADER_SIZE)
+
+/*
+ * X(NAME, id, Struct, fields): fields is a sequence of F(type, name), in wire order.
+ * Field types are fixed-width integers.
+ */
+#define RF_MESSAGES(X)                                                                     \
+    X(REBOOT,      1, RFReboot, )                                                          \
+    X(RF_SYNC,     2, RFSyncRequest, )                                                     \
+    X(TIME_SYNC,   3, RFTimeSync, F(uint64_t, gateway_ms))                                 \
+    X(LOG_NUMBER,  4, RFLogNumber, F(int16_t, log_number))                                 \
+    X(PONG,        5, RFPong, F(int16_t, log_number))                                      \
+    X(SCHEDULE,    6, RFSchedule, F(uint64_t, start_ms) F(uint32_t, rate_hz)               \
+                      F(uint32_t, duration_s) F(uint8_t, range_g) F(uint16_t, dlpf_hz))    \
+    X(TRIGGER_ON,  7, RFTriggerOn, F(uint16_t, rate_hz) F(uint16_t, post_s))               \
+    X(TRIGGER_OFF, 8, RFTriggerOff, )                                                      \
+    X(EVENT,       9, RFEvent, F(uint16_t, log_number) F(uint64_t, trigger_ms))                \
+    X(CONFIRM,    10, RFConfirm, F(uint8_t, seq))                                         \
+    X(STATUS,     11, RFStatus, F(uint8_t, state) F(uint8_t, flags) F(int16_t, log_number)    \
+                      F(uint32_t, sd_free_kb) F(int32_t, drift_ppm) F(uint32_t, since_sync_s)  \
+                      F(uint32_t, uptime_s) F(uint8_t, tx_retries) F(uint8_t, signal_strong))  \
+    X(POLL,       12, RFPoll, )                                                           \
+    X(BULK_GET,   13, RFBulkGet, F(uint16_t, log_number))                                  \
+    X(BULK_INFO,  14, RFBulkInfo, F(uint16_t, log_number) F(uint32_t, blocks) F(uint32_t, bytes)) \
+    X(BULK_WANT,  15, RFBulkWant, F(uint32_t, first_block) F(uint8_t, blocks))
+
+struct RFMessage
+{
+    uint8_t version;  // RF_MSG_VERSION
+    uint8_t type;     // RFMsgType
+    uint8_t from_id;
+    uint8_t to_id;
+    uint8_t seq;      // Per sender; a message repeated for reliability keeps its number
+    uint8_t payload[RF_PAYLOAD_SIZE];
+    uint8_t length;   // Payload bytes in use; not sent, the dynamic payload length carries it
+};
+
+static_assert(offsetof(RFMessage, payload) == RF_HEADER_SIZE, "RFMessage header must be packed");
+static_assert(offsetof(RFMessage, length) == RF_MSG_SIZE, "Everything before length goes over the air");
+
+// === Generated from RF_MESSAGES ===
+
+// F() is Arduino's flash string macro; borrowed for the field lists and restored at the end
+#pragma push_macro("F")
+#undef F
+
+enum class RFMsgType : uint8_t
+{
+#define X(NAME, ID, STRUCT, FIELDS) NAME = ID,
+    RF_MESSAGES(X)
+#undef X
+};
+
+#define F(TYPE, FIELD) TYPE FIELD;
+#define X(NAME, ID, STRUCT, FIELDS) \
+    struct STRUCT                   \
+    {                               \
+        FIELDS                      \
+    };
+RF_MESSAGES(X)
+#undef X
+#undef F
+
+// Wire size of each type's fields, e.g. RF_SIZE_SCHEDULE
+#define F(TYPE, FIELD) +sizeof(TYPE)
+#define X(NAME, ID, STRUCT, FIELDS)                                           \
+    constexpr uint8_t RF_SIZE_##NAME = 0 FIELDS;                              \
+    static_assert(RF_SIZE_##NAME <= RF_PAYLOAD_SIZE, #STRUCT " does not fit in one RF payload");
+RF_MESSAGES(X)
+#undef X
+#undef F
+
+// Little-endian field access, independent of the host byte order
+template <typename T>
+inline uint8_t *rf_msg_put(uint8_t *p, T value)
+{
+    for (size_t i = 0; i < sizeof(T); ++i)
+        *p++ = (uint8_t)((uint64_t)value >> (8 * i));
+    return p;
+}
+
+template <typename T>
+inline const uint8_t *rf_msg_get(const uint8_t *p, T &value)
+{
+    uint64_t raw = 0;
+    for (size_t i = 0; i < sizeof(T); ++i)
+        raw |= (uint64_t)*p++ << (8 * i);
+    value = (T)raw;
+    return p;
+}
+
+// rf_msg_encode(msg, fields): sets type, payload and length; the header fields are the caller's
+#define F(TYPE, FIELD) p = rf_msg_put(p, fields.FIELD);
+#define X(NAME, ID, STRUCT, FIELDS)                                     \
+    inline void rf_msg_encode(RFMessage &msg, const STRUCT &fields)     \
+    {                                                                   \
+        uint8_t *p = msg.payload;                                       \
+        FIELDS                                                          \
+        (void)p;                                                        \
+        (void)fields;                                                   \
+        msg.type = (uint8_t)RFMsgType::NAME;                            \
+        msg.length = RF_SIZE_##NAME;                                    \
+    }
+RF_MESSAGES(X)
+#undef X
+#undef F
+
+// rf_msg_decode(msg, fields): false if msg is not of that type or has the wrong length
+#define F(TYPE, FIELD) p = rf_msg_get(p, fields.FIELD);
+#define X(NAME, ID, STRUCT, FIELDS)                                                          \
+    inline bool rf_msg_decode(const RFMessage &msg, STRUCT &fields)                          \
+    {                                                                                        \
+        if (msg.type != (uint8_t)RFMsgType::NAME || msg.length != RF_SIZE_##NAME)            \
+            return false;                                                                    \
+        const uint8_t *p = msg.payload;                                                      \
+        FIELDS                                                                               \
+        (void)p;                                                                             \
+        (void)fields;                                                                        \
+        return true;                                                                         \
+    }
+RF_MESSAGES(X)
+#undef X
+#undef F
+
+// Type name for logs, "?" if unknown
+inline const char *rf_msg_name(uint8_t type)
+{
+    switch (type)
+    {
+#define X(NAME, ID, STRUCT, FIELDS) \
+    case ID:                        \
+        return #NAME;
+        RF_MESSAGES(X)
+#undef X
+    default:
+        return "?";
+    }
+}
+
+#pragma pop_macro("F")
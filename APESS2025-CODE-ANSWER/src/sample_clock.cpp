@@ -0,0 +1,132 @@
+#include "sample_clock.hpp"
+#include "spsc_queue.hpp"
+
+static SpscQueue<uint32_t, SAMPLE_CLOCK_QUEUE_LEN> tick_queue;
+static uint32_t next_tick = 0; // Only touched by the producer once the clock runs
+static volatile uint32_t overruns = 0;
+
+// Producer side, runs in interrupt context on the board
+static void sample_clock_post_tick()
+{
+    if (!tick_queue.push(next_tick))
+    {
+        overruns = overruns + 1;
+    }
+    next_tick++;
+}
+
+static void sample_clock_reset()
+{
+    tick_queue.clear();
+    next_tick = 0;
+    overruns = 0;
+}
+
+#ifdef ARDUINO
+
+#include <Arduino.h>
+#include <FspTimer.h>
+
+static FspTimer sample_timer;
+static bool timer_running = false;
+
+static void sample_clock_isr(timer_callback_args_t *args)
+{
+    (void)args;
+    sample_clock_post_tick();
+}
+
+bool sample_clock_start(uint32_t rate_hz, float drift_ratio)
+{
+    if (timer_running)
+        sample_clock_stop();
+
+    if (rate_hz == 0)
+        return false;
+
+    uint8_t timer_type = GPT_TIMER;
+    int8_t timer_channel = FspTimer::get_available_timer(timer_type);
+    if (timer_channel < 0)
+    {
+        Serial.println("[SENSING] No hardware timer available.");
+        return false;
+    }
+
+    // The timer counts local time; unified = local * drift_ratio
+    float local_freq_hz = static_cast<float>(rate_hz) * drift_ratio;
+
+    sample_clock_reset();
+
+    if (!sample_timer.begin(TIMER_MODE_PERIODIC, timer_type, timer_channel, local_freq_hz, 0.0f, sample_clock_isr) ||
+        !sample_timer.setup_overflow_irq() ||
+        !sample_timer.open())
+    {
+        Serial.println("[SENSING] Failed to configure sample timer.");
+        sample_timer.end();
+        return false;
+    }
+
+    sample_clock_post_tick(); // Tick 0 is the scheduled start itself
+    sample_timer.start();
+    timer_running = true;
+    return true;
+}
+
+void sample_clock_stop()
+{
+    if (!timer_running)
+        return;
+
+    sample_timer.stop();
+    sample_timer.end();
+    timer_running = false;
+}
+
+#else // Simulated clock for host builds
+
+static bool sim_running = false;
+static double sim_period_us = 0.0;   // Local period between ticks
+static double sim_local_us = 0.0;    // Local time since start
+
+bool sample_clock_start(uint32_t rate_hz, float drift_ratio)
+{
+    if (rate_hz == 0)
+        return false;
+
+    sample_clock_reset();
+    sim_period_us = 1e6 / (static_cast<double>(rate_hz) * drift_ratio);
+    sim_local_us = 0.0;
+    sim_running = true;
+
+    sample_clock_post_tick();
+    return true;
+}
+
+void sample_clock_stop()
+{
+    sim_running = false;
+}
+
+void sample_clock_sim_advance_us(uint64_t local_us)
+{
+    if (!sim_running)
+        return;
+
+    sim_local_us += static_cast<double>(local_us);
+    while (next_tick * sim_period_us <= sim_local_us)
+    {
+        sample_clock_post_tick();
+    }
+}
+
+#endif
+
+bool sample_clock_pop(uint32_t &tick)
+{
+    return tick_queue.pop(tick);
+}
+
+uint32_t sample_clock_overruns()
+{
+    return overruns;
+}
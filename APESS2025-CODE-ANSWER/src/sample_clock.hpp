@@ -0,0 +1,35 @@
+#pragma once
+
+#include <stdint.h>
+
+#define SAMPLE_CLOCK_QUEUE_LEN 64 // Pending ticks the loop may fall behind by (power of two)
+
+/*
+ * Sample clock - periodic hardware timer that schedules IMU reads.
+ *
+ * The timer ISR only posts the index n of each tick into a lock-free SPSC
+ * queue; loop() pops the ticks and performs the I2C read (which is not safe in
+ * interrupt context). Tick n is nominally taken at n * 1000 / rate_hz ms after
+ * the start, so timestamps carry no accumulated rounding error whatever the rate.
+ *
+ * On the board the timer is an FspTimer (GPT/AGT) on the local crystal, so its
+ * frequency is corrected by the sync drift ratio to tick at rate_hz in unified
+ * network time. Without ARDUINO the clock is simulated and advanced by hand,
+ * which lets the scheduling logic build and run on a host.
+ */
+
+bool sample_clock_start(uint32_t rate_hz, float drift_ratio); // Tick 0 is posted immediately
+void sample_clock_stop();
+
+bool sample_clock_pop(uint32_t &tick);    // Next pending tick index, false if none
+uint32_t sample_clock_overruns();         // Ticks lost because the queue was full
+
+// Elapsed unified time of tick n since the start, in ms
+inline uint32_t sample_clock_tick_ms(uint32_t tick, uint32_t rate_hz)
+{
+    return static_cast<uint32_t>(static_cast<uint64_t>(tick) * 1000ULL / rate_hz);
+}
+
+#ifndef ARDUINO
+void sample_clock_sim_advance_us(uint64_t local_us); // Simulated backend: let local time pass
+#endif
@@ -0,0 +1,205 @@
+#include <string.h>
+#include "sample_codec.hpp"
+
+#define SAMPLE_CODEC_TIME_BITS 32 // Raw width of an escaped time residual
+#define SAMPLE_CODEC_AXIS_BITS 17 // Raw width of an escaped axis residual
+#define SAMPLE_CODEC_MAX_K     16
+#define SAMPLE_CODEC_RESCALE   64 // Halve the running sums at this count, tracks drifting noise levels
+
+static uint32_t zigzag(int32_t v)
+{
+    return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+}
+
+static int32_t unzigzag(uint32_t v)
+{
+    return (int32_t)(v >> 1) ^ -(int32_t)(v & 1);
+}
+
+static void channel_reset(SampleCodecChannel &ch)
+{
+    ch.sum = 2;
+    ch.count = 1;
+}
+
+static uint8_t channel_k(const SampleCodecChannel &ch)
+{
+    uint8_t k = 0;
+    while (k < SAMPLE_CODEC_MAX_K && ((uint32_t)ch.count << k) < ch.sum)
+        k++;
+    return k;
+}
+
+static void channel_update(SampleCodecChannel &ch, uint32_t v)
+{
+    ch.sum += v;
+    if (++ch.count == SAMPLE_CODEC_RESCALE)
+    {
+        ch.sum >>= 1;
+        ch.count >>= 1;
+    }
+}
+
+// === Encoder ===
+
+static void put_bits(SampleCodedBlock &block, uint32_t value, uint8_t n)
+{
+    while (n > 0)
+    {
+        uint16_t pos = block.header.bits;
+        uint8_t free_bits = 8 - (pos & 7);
+        uint8_t take = n < free_bits ? n : free_bits;
+        uint8_t chunk = (value >> (n - take)) & ((1u << take) - 1);
+        block.payload[pos >> 3] |= chunk << (free_bits - take);
+        block.header.bits += take;
+        n -= take;
+    }
+}
+
+static void put_rice(SampleCodedBlock &block, SampleCodecChannel &ch, uint32_t v, uint8_t raw_bits)
+{
+    uint8_t k = channel_k(ch);
+    uint32_t q = v >> k;
+    if (q < SAMPLE_CODEC_ESCAPE)
+    {
+        put_bits(block, ((1u << q) - 1) << 1, q + 1); // q ones and a zero
+        put_bits(block, v, k);
+    }
+    else
+    {
+        put_bits(block, (1u << SAMPLE_CODEC_ESCAPE) - 1, SAMPLE_CODEC_ESCAPE);
+        put_bits(block, v, raw_bits);
+    }
+    channel_update(ch, v);
+}
+
+void sample_encoder_reset(SampleEncoder &enc)
+{
+    memset(&enc.block, 0, sizeof(enc.block));
+    enc.block.header.magic = SAMPLE_CODED_MAGIC;
+}
+
+bool sample_encoder_push(SampleEncoder &enc, uint32_t elapsed_ms, int16_t ax, int16_t ay, int16_t az)
+{
+    SampleCodedBlock &block = enc.block;
+    const int16_t v[3] = {ax, ay, az};
+
+    if (block.header.count == 0)
+    {
+        block.header.t0_ms = elapsed_ms;
+        memcpy(block.header.first, v, sizeof(v));
+        for (uint8_t i = 0; i < 4; ++i)
+            channel_reset(enc.channels[i]);
+        enc.last_ms = elapsed_ms;
+        enc.last_dt = 0;
+        memcpy(enc.last, v, sizeof(v));
+        block.header.count = 1;
+        return true;
+    }
+
+    // Worst case check keeps the encoder single pass
+    if ((uint32_t)block.header.bits + SAMPLE_CODEC_MAX_RECORD_BITS > SAMPLE_CODED_PAYLOAD * 8)
+        return false;
+
+    int32_t dt = (int32_t)(elapsed_ms - enc.last_ms);
+    put_rice(block, enc.channels[0], zigzag(dt - enc.last_dt), SAMPLE_CODEC_TIME_BITS);
+    enc.last_ms = elapsed_ms;
+    enc.last_dt = dt;
+
+    for (uint8_t i = 0; i < 3; ++i)
+    {
+        put_rice(block, enc.channels[i + 1], zigzag((int32_t)v[i] - enc.last[i]), SAMPLE_CODEC_AXIS_BITS);
+        enc.last[i] = v[i];
+    }
+
+    block.header.count++;
+    return true;
+}
+
+// === Decoder ===
+
+typedef struct {
+    const uint8_t *data;
+    uint32_t pos;
+    uint32_t end;
+} BitReader;
+
+static bool get_bits(BitReader &in, uint8_t n, uint32_t &value)
+{
+    if (in.pos + n > in.end)
+        return false;
+
+    value = 0;
+    for (uint8_t i = 0; i < n; ++i, ++in.pos)
+        value = (value << 1) | ((in.data[in.pos >> 3] >> (7 - (in.pos & 7))) & 1);
+    return true;
+}
+
+static bool get_rice(BitReader &in, SampleCodecChannel &ch, uint8_t raw_bits, uint32_t &v)
+{
+    uint8_t k = channel_k(ch);
+    uint32_t q = 0, bit = 1;
+    while (q < SAMPLE_CODEC_ESCAPE)
+    {
+        if (!get_bits(in, 1, bit))
+            return false;
+        if (!bit)
+            break;
+        q++;
+    }
+
+    uint32_t low = 0;
+    if (q == SAMPLE_CODEC_ESCAPE)
+    {
+        if (!get_bits(in, raw_bits, v))
+            return false;
+    }
+    else
+    {
+        if (!get_bits(in, k, low))
+            return false;
+        v = (q << k) | low;
+    }
+    channel_update(ch, v);
+    return true;
+}
+
+int sample_decode_block(const SampleCodedBlock &block, uint32_t *elapsed_ms, int16_t (*xyz)[3])
+{
+    const SampleCodedHeader &header = block.header;
+    if (header.magic != SAMPLE_CODED_MAGIC || header.count == 0 ||
+        header.count > SAMPLE_CODED_MAX_RECORDS || header.bits > SAMPLE_CODED_PAYLOAD * 8)
+        return -1;
+
+    SampleCodecChannel channels[4];
+    for (uint8_t i = 0; i < 4; ++i)
+        channel_reset(channels[i]);
+
+    BitReader in = {block.payload, 0, header.bits};
+    uint32_t last_ms = header.t0_ms;
+    int32_t last_dt = 0;
+    int16_t last[3] = {header.first[0], header.first[1], header.first[2]};
+
+    elapsed_ms[0] = last_ms;
+    memcpy(xyz[0], last, sizeof(last));
+
+    for (uint16_t n = 1; n < header.count; ++n)
+    {
+        uint32_t v;
+        if (!get_rice(in, channels[0], SAMPLE_CODEC_TIME_BITS, v))
+            return -1;
+        last_dt += unzigzag(v);
+        last_ms += (uint32_t)last_dt;
+        elapsed_ms[n] = last_ms;
+
+        for (uint8_t i = 0; i < 3; ++i)
+        {
+            if (!get_rice(in, channels[i + 1], SAMPLE_CODEC_AXIS_BITS, v))
+                return -1;
+            last[i] = (int16_t)(last[i] + unzigzag(v));
+            xyz[n][i] = last[i];
+        }
+    }
+
+    return header.count;
+}
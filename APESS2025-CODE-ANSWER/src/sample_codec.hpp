@@ -0,0 +1,67 @@
+#pragma once
+
+#include <stdint.h>
+#include "sample_format.hpp"
+
+/*
+ * Lossless block codec for sample records (SAMPLE_CODEC_RICE).
+ *
+ * Each SampleCodedBlock holds its first record verbatim in the header and
+ * codes the following ones as residuals in a bit stream (MSB first):
+ *
+ *   time : second difference of elapsed_ms (0 at a steady rate)
+ *   axes : first difference of ax, ay, az
+ *
+ * Residuals are zig-zag mapped and Rice coded with a parameter k adapted per
+ * channel from the running mean of the coded values, as in LOCO-I. Unary
+ * quotients of SAMPLE_CODEC_ESCAPE ones or more are replaced by the escape
+ * followed by the raw value, which bounds every record to
+ * SAMPLE_CODEC_MAX_RECORD_BITS. Blocks decode on their own; the adaptive state
+ * restarts in every block.
+ *
+ * This file only depends on <stdint.h> so host tools can link sample_codec.cpp.
+ */
+
+#define SAMPLE_CODED_MAGIC  0x4243 // "CB"
+#define SAMPLE_CODEC_ESCAPE 16     // Unary length that switches to a raw value
+
+typedef struct {
+    uint16_t magic;      // SAMPLE_CODED_MAGIC
+    uint16_t count;      // Number of records, including the first
+    uint32_t t0_ms;      // Elapsed time of the first record since sensing started (ms)
+    int16_t first[3];    // First record, ax, ay, az
+    uint16_t bits;       // Payload bits used
+} SampleCodedHeader;
+
+#define SAMPLE_CODED_PAYLOAD (SAMPLE_BLOCK_SIZE - sizeof(SampleCodedHeader))
+#define SAMPLE_CODEC_MAX_RECORD_BITS ((SAMPLE_CODEC_ESCAPE + 32) + 3 * (SAMPLE_CODEC_ESCAPE + 17))
+#define SAMPLE_CODED_MAX_RECORDS (1 + SAMPLE_CODED_PAYLOAD * 8 / 4) // At least one bit per channel
+
+typedef struct {
+    SampleCodedHeader header;
+    uint8_t payload[SAMPLE_CODED_PAYLOAD];
+} SampleCodedBlock;
+
+static_assert(sizeof(SampleCodedBlock) == SAMPLE_BLOCK_SIZE, "SampleCodedBlock must fill exactly one block");
+
+// Adaptive Rice state of one channel
+typedef struct {
+    uint32_t sum;    // Sum of recent coded values
+    uint16_t count;  // Number of values in sum
+} SampleCodecChannel;
+
+typedef struct {
+    SampleCodedBlock block;
+    uint32_t last_ms;
+    int32_t last_dt;
+    int16_t last[3];
+    SampleCodecChannel channels[4]; // time, ax, ay, az
+} SampleEncoder;
+
+void sample_encoder_reset(SampleEncoder &enc);
+
+// Append one record; false if the block is full, the record is then left for the next block
+bool sample_encoder_push(SampleEncoder &enc, uint32_t elapsed_ms, int16_t ax, int16_t ay, int16_t az);
+
+// Decode a block into elapsed_ms[] / xyz[], each with room for SAMPLE_CODED_MAX_RECORDS; -1 if corrupt
+int sample_decode_block(const SampleCodedBlock &block, uint32_t *elapsed_ms, int16_t (*xyz)[3]);
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <stdint.h>
+#include "sensing.hpp"
+
+/*
+ * Binary sample log format
+ *
+ * The file is a sequence of 512-byte blocks so that every write lines up with
+ * an SD sector (all fields little-endian, as stored by the RA4M1):
+ *
+ *   block 0      : SampleFileHeader, zero padded to SAMPLE_BLOCK_SIZE
+ *   block 1 .. n : SampleBlock, up to SAMPLE_BLOCK_CAPACITY records each, or
+ *                  SampleCodedBlock when the header says SAMPLE_CODEC_RICE
+ *
+ * SamplePoint::elapsed_ms is relative to the t0_ms of its block, so each block
+ * decodes on its own and the 16-bit field never wraps inside a block.
+ * This header only depends on <stdint.h> so host tools can include it.
+ */
+
+#define SAMPLE_FILE_MAGIC   0x42535041UL // "APSB"
+#define SAMPLE_FILE_VERSION 1
+#define SAMPLE_FILE_EXT     ".BIN"
+
+#define SAMPLE_BLOCK_SIZE   512
+#define SAMPLE_BLOCK_MAGIC  0x4B42 // "BK"
+
+typedef struct {
+    uint32_t magic;        // SAMPLE_FILE_MAGIC
+    uint16_t version;      // SAMPLE_FILE_VERSION
+    uint16_t header_size;  // Bytes reserved for the header (one block)
+    uint16_t block_size;   // SAMPLE_BLOCK_SIZE
+    uint16_t record_size;  // sizeof(SamplePoint)
+    uint16_t node_id;
+    uint16_t log_number;
+    uint64_t start_ms;     // Scheduled start time (Unix ms, unified network time)
+    uint32_t rate_hz;      // Sampling rate in Hz
+    uint32_t duration_s;   // Scheduled duration in seconds
+    float lsb_per_g;       // Raw counts per g for the configured range
+    float cali_scale_x;    // Calibration scale for X-axis
+    float cali_scale_y;    // Calibration scale for Y-axis
+    float cali_scale_z;    // Calibration scale for Z-axis
+    uint16_t range_g;      // Accelerometer full scale in g
+    uint16_t dlpf_hz;      // Anti-alias (DLPF) bandwidth in Hz
+    uint32_t sensor_rate_hz; // Sensor internal sample rate in Hz
+    uint16_t decimation;   // Acquisition rate / rate_hz (1 = not decimated)
+    uint16_t fir_taps;     // Taps of the decimation FIR, delay compensated in the timestamps
+    uint16_t flags;        // SAMPLE_FLAG_*
+    uint16_t codec;        // SAMPLE_CODEC_*, layout of the data blocks
+    uint32_t trigger_ms;   // SAMPLE_FLAG_TRIGGERED: elapsed time of the trigger, records before it are pre-trigger
+} SampleFileHeader;
+
+#define SAMPLE_FLAG_TRIGGERED 0x0001 // Event recording: start_ms is the oldest pre-trigger record
+
+#define SAMPLE_CODEC_RAW  0 // SampleBlock
+#define SAMPLE_CODEC_RICE 1 // SampleCodedBlock, see sample_codec.hpp
+
+typedef struct {
+    uint16_t magic;  // SAMPLE_BLOCK_MAGIC
+    uint16_t count;  // Number of valid records in this block
+    uint32_t t0_ms;  // Elapsed time of the block origin since sensing started (ms)
+} SampleBlockHeader;
+
+#define SAMPLE_BLOCK_CAPACITY ((SAMPLE_BLOCK_SIZE - sizeof(SampleBlockHeader)) / sizeof(SamplePoint))
+
+typedef struct {
+    SampleBlockHeader header;
+    SamplePoint samples[SAMPLE_BLOCK_CAPACITY];
+} SampleBlock;
+
+static_assert(sizeof(SamplePoint) == 8, "SamplePoint must stay packed to 8 bytes");
+static_assert(sizeof(SampleFileHeader) <= SAMPLE_BLOCK_SIZE, "SampleFileHeader must fit in one block");
+static_assert(sizeof(SampleBlock) == SAMPLE_BLOCK_SIZE, "SampleBlock must fill exactly one block");
+
+/*
+ * Spectrum summary file
+ *
+ * Written next to the sample log when SENSING_SPECTRUM is enabled, same name
+ * with SPECTRUM_FILE_EXT: a SpectrumFileHeader with the strongest peaks of
+ * each axis, followed by the Welch PSD of each axis as int16 in 0.01 dB
+ * re 1 g^2/Hz (SPECTRUM_DB_FLOOR marks bins below the representable range),
+ * stored as psd[axis][bin] for axis x, y, z and bins 0 .. fft_size / 2.
+ */
+
+#define SPECTRUM_FILE_MAGIC   0x50535041UL // "APSP"
+#define SPECTRUM_FILE_VERSION 1
+#define SPECTRUM_FILE_EXT     ".PSD"
+
+#define SPECTRUM_FFT_SIZE 256
+#define SPECTRUM_BINS     (SPECTRUM_FFT_SIZE / 2 + 1)
+#define SPECTRUM_PEAKS    5
+#define SPECTRUM_DB_FLOOR INT16_MIN
+
+typedef struct {
+    float freq_hz;         // Interpolated peak frequency, 0 if unused
+    float psd;             // PSD at the peak bin (g^2/Hz)
+} SpectrumPeak;
+
+typedef struct {
+    uint32_t magic;        // SPECTRUM_FILE_MAGIC
+    uint16_t version;      // SPECTRUM_FILE_VERSION
+    uint16_t header_size;  // Bytes before the PSD table
+    uint16_t node_id;
+    uint16_t log_number;   // Same as the sample log it summarises
+    uint16_t fft_size;     // Segment length (Hann window, 50% overlap)
+    uint16_t bins;         // PSD bins per axis
+    uint64_t start_ms;     // Scheduled start time (Unix ms, unified network time)
+    float rate_hz;         // Rate of the analysed records
+    float bin_hz;          // Frequency step between bins
+    uint32_t segments;     // Segments averaged
+    SpectrumPeak peaks[3][SPECTRUM_PEAKS]; // Per axis, strongest first
+} SpectrumFileHeader;
@@ -0,0 +1,120 @@
+#include <string.h>
+#include "sample_ring.hpp"
+
+static_assert(SAMPLE_RING_BLOCKS >= 2, "SAMPLE_RING_BLOCKS must be at least 2");
+
+static SampleBlock ring[SAMPLE_RING_BLOCKS];
+static volatile uint8_t ring_head = 0; // Block being filled
+static volatile uint8_t ring_tail = 0; // Oldest block waiting for the card
+static volatile uint8_t ring_ready = 0; // Number of full blocks waiting for the card
+static bool ring_full = false;          // All blocks are waiting, sampling drops records
+static SampleRingStats stats;
+
+static void sample_ring_commit()
+{
+    SampleBlock &block = ring[ring_head];
+
+    // Zero the unused tail so a short block does not carry stale records
+    memset(&block.samples[block.header.count], 0,
+           (SAMPLE_BLOCK_CAPACITY - block.header.count) * sizeof(SamplePoint));
+
+    ring_head = (ring_head + 1) % SAMPLE_RING_BLOCKS;
+    ring_ready++;
+    if (ring_ready > stats.high_water)
+        stats.high_water = ring_ready;
+
+    if (ring_ready == SAMPLE_RING_BLOCKS)
+    {
+        ring_full = true;
+        return;
+    }
+
+    ring[ring_head].header.magic = SAMPLE_BLOCK_MAGIC;
+    ring[ring_head].header.count = 0;
+}
+
+void sample_ring_reset()
+{
+    ring_head = ring_tail = ring_ready = 0;
+    ring_full = false;
+    memset(&stats, 0, sizeof(stats));
+
+    ring[0].header.magic = SAMPLE_BLOCK_MAGIC;
+    ring[0].header.count = 0;
+}
+
+bool sample_ring_push(uint32_t elapsed_ms, int16_t ax, int16_t ay, int16_t az)
+{
+    if (ring_full)
+    {
+        // Resume as soon as the flush path has freed a block
+        if (ring_ready == SAMPLE_RING_BLOCKS)
+        {
+            stats.overruns++;
+            return false;
+        }
+        ring_full = false;
+        ring[ring_head].header.magic = SAMPLE_BLOCK_MAGIC;
+        ring[ring_head].header.count = 0;
+    }
+
+    SampleBlock *block = &ring[ring_head];
+
+    // Start a new block when the current one is full or its 16-bit offsets would wrap
+    if (block->header.count == SAMPLE_BLOCK_CAPACITY ||
+        (block->header.count > 0 && elapsed_ms - block->header.t0_ms > 0xFFFF))
+    {
+        sample_ring_commit();
+        if (ring_full)
+        {
+            stats.overruns++;
+            return false;
+        }
+        block = &ring[ring_head];
+    }
+
+    if (block->header.count == 0)
+        block->header.t0_ms = elapsed_ms;
+
+    SamplePoint &point = block->samples[block->header.count++];
+    point.elapsed_ms = elapsed_ms - block->header.t0_ms;
+    point.ax = ax;
+    point.ay = ay;
+    point.az = az;
+
+    if (block->header.count == SAMPLE_BLOCK_CAPACITY)
+        sample_ring_commit(); // Make it available to the flush path right away
+
+    return true;
+}
+
+void sample_ring_seal()
+{
+    if (!ring_full && ring[ring_head].header.count > 0)
+        sample_ring_commit();
+}
+
+const SampleBlock *sample_ring_ready()
+{
+    return ring_ready ? &ring[ring_tail] : nullptr;
+}
+
+void sample_ring_release()
+{
+    if (!ring_ready)
+        return;
+
+    ring_tail = (ring_tail + 1) % SAMPLE_RING_BLOCKS;
+    ring_ready--;
+    stats.blocks_written++;
+}
+
+uint8_t sample_ring_pending()
+{
+    return ring_ready;
+}
+
+const SampleRingStats &sample_ring_stats()
+{
+    return stats;
+}
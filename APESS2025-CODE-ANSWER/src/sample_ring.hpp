@@ -0,0 +1,36 @@
+#pragma once
+
+#include <stdint.h>
+#include "sample_format.hpp"
+
+#define SAMPLE_RING_BLOCKS 4 // Number of 512-byte blocks buffered in RAM (>= 2)
+
+/*
+ * Ring of SampleBlock buffers between acquisition and SD storage.
+ *
+ * The sampling path only appends records to the block being filled; once it is
+ * full it is handed over to the flush path, which drains ready blocks to the
+ * card between samples. If every block is still waiting for the card, new
+ * samples are dropped and counted as overruns instead of stalling sampling.
+ */
+
+typedef struct {
+    uint32_t blocks_written;   // Blocks handed to the card
+    uint32_t overruns;         // Samples dropped because no block was free
+    uint8_t high_water;        // Maximum number of blocks waiting for the card
+} SampleRingStats;
+
+void sample_ring_reset();
+
+// Sampling side: append one record taken at `elapsed_ms` since sensing started
+bool sample_ring_push(uint32_t elapsed_ms, int16_t ax, int16_t ay, int16_t az);
+
+// Hand the partially filled block over to the flush path (end of sensing)
+void sample_ring_seal();
+
+// Flush side: oldest full block, or nullptr if none is ready
+const SampleBlock *sample_ring_ready();
+void sample_ring_release(); // Release the block returned by sample_ring_ready()
+
+uint8_t sample_ring_pending();
+const SampleRingStats &sample_ring_stats();
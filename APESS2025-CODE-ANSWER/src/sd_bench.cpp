@@ -0,0 +1,288 @@
+#include <stdlib.h>
+#include <string.h>
+#include "sd_bench.hpp"
+#include "sdcard.hpp"
+
+#define SD_BENCH_OPEN_CLOSE_RECORDS 256 // OPEN_WRITE_CLOSE costs a directory update per record, keep it short
+
+static uint32_t latency[SD_BENCH_LATENCY_SAMPLES];
+static uint32_t latency_seen = 0;
+static uint32_t latency_max = 0;
+static uint32_t reservoir_seed = 1;
+static uint8_t block_buf[512];
+static uint8_t record_buf[512];
+
+static const char *const mode_names[] = {
+    "OPEN_WRITE_CLOSE",
+    "APPEND",
+    "APPEND_FLUSH",
+    "CONTIGUOUS",
+    "BLOCK",
+};
+
+static_assert(sizeof(mode_names) / sizeof(mode_names[0]) == (size_t)SdBenchMode::COUNT, "One name per SdBenchMode");
+
+const char *sd_bench_mode_name(SdBenchMode mode)
+{
+    return mode < SdBenchMode::COUNT ? mode_names[(size_t)mode] : "?";
+}
+
+// Content of byte `offset` of the scratch file, position dependent so shifted or lost data shows up
+static uint8_t pattern_byte(uint32_t offset)
+{
+    return (uint8_t)(offset * 7 + (offset >> 9));
+}
+
+static void fill_pattern(uint8_t *dst, uint32_t offset, uint16_t len)
+{
+    for (uint16_t i = 0; i < len; ++i)
+        dst[i] = pattern_byte(offset + i);
+}
+
+static void latency_reset()
+{
+    latency_seen = 0;
+    latency_max = 0;
+    reservoir_seed = 1;
+}
+
+// Reservoir sampling keeps a uniform subset of all appends in fixed RAM
+static void latency_add(uint32_t us)
+{
+    if (us > latency_max)
+        latency_max = us;
+
+    if (latency_seen < SD_BENCH_LATENCY_SAMPLES)
+    {
+        latency[latency_seen] = us;
+    }
+    else
+    {
+        reservoir_seed = reservoir_seed * 1664525UL + 1013904223UL;
+        uint32_t slot = reservoir_seed % (latency_seen + 1);
+        if (slot < SD_BENCH_LATENCY_SAMPLES)
+            latency[slot] = us;
+    }
+    latency_seen++;
+}
+
+static int compare_u32(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+static void latency_summarize(SdBenchResult &result)
+{
+    uint32_t n = latency_seen < SD_BENCH_LATENCY_SAMPLES ? latency_seen : SD_BENCH_LATENCY_SAMPLES;
+    result.max_us = latency_max;
+    if (n == 0)
+        return;
+
+    qsort(latency, n, sizeof(latency[0]), compare_u32);
+    result.p50_us = latency[(n - 1) / 2];
+    result.p99_us = latency[(n - 1) * 99 / 100];
+}
+
+static bool verify_file(uint32_t bytes)
+{
+    File file = SD.open(SD_BENCH_FILE, FILE_READ);
+    if (!file)
+        return false;
+
+    bool ok = file.size() >= bytes;
+    for (uint32_t offset = 0; ok && offset < bytes; offset += sizeof(block_buf))
+    {
+        uint16_t len = bytes - offset < sizeof(block_buf) ? bytes - offset : sizeof(block_buf);
+        ok = file.read(block_buf, len) == len;
+        for (uint16_t i = 0; ok && i < len; ++i)
+            ok = block_buf[i] == pattern_byte(offset + i);
+    }
+    file.close();
+    return ok;
+}
+
+// Record-at-a-time paths through the file system
+static bool run_file(SdBenchMode mode, uint16_t record_size, uint32_t records)
+{
+    File file;
+    bool ok = true;
+
+    if (mode != SdBenchMode::OPEN_WRITE_CLOSE)
+    {
+        file = SD.open(SD_BENCH_FILE, FILE_WRITE);
+        if (!file)
+            return false;
+    }
+
+    for (uint32_t r = 0; r < records; ++r)
+    {
+        fill_pattern(record_buf, r * record_size, record_size);
+
+        uint32_t t0 = micros();
+        if (mode == SdBenchMode::OPEN_WRITE_CLOSE)
+        {
+            file = SD.open(SD_BENCH_FILE, FILE_WRITE);
+            ok = file && file.write(record_buf, record_size) == record_size;
+            if (file)
+                file.close();
+        }
+        else
+        {
+            ok = file.write(record_buf, record_size) == record_size;
+            if (mode == SdBenchMode::APPEND_FLUSH)
+                file.flush();
+        }
+        latency_add(micros() - t0);
+
+        if (!ok)
+            break;
+    }
+
+    if (mode != SdBenchMode::OPEN_WRITE_CLOSE)
+        file.close();
+    return ok;
+}
+
+// Whole-block paths into a pre-allocated file; records are packed across block boundaries
+static bool run_blocks(SdBenchMode mode, uint16_t record_size, uint32_t records)
+{
+    uint32_t bytes = records * record_size;
+    uint32_t blocks = (bytes + sizeof(block_buf) - 1) / sizeof(block_buf);
+    uint32_t first_block = 0;
+    uint32_t last_block = 0;
+    File file;
+
+    if (mode == SdBenchMode::CONTIGUOUS)
+    {
+        if (!sdcard_log_open(file, SD_BENCH_FILE, blocks * sizeof(block_buf)))
+            return false;
+    }
+    else
+    {
+        file = SD.createContiguous(SD_BENCH_FILE, blocks * sizeof(block_buf));
+        if (!file || !file.contiguousRange(first_block, last_block))
+        {
+            if (file)
+                file.close();
+            return false;
+        }
+    }
+
+    bool ok = true;
+    uint32_t written = 0;
+    uint16_t fill = 0;
+
+    for (uint32_t r = 0; ok && r < records; ++r)
+    {
+        fill_pattern(record_buf, r * record_size, record_size);
+
+        uint32_t t0 = micros();
+        for (uint16_t done = 0; ok && done < record_size;)
+        {
+            uint16_t n = record_size - done;
+            if (n > sizeof(block_buf) - fill)
+                n = sizeof(block_buf) - fill;
+            memcpy(block_buf + fill, record_buf + done, n);
+            fill += n;
+            done += n;
+
+            bool last = r == records - 1 && done == record_size;
+            if (fill < sizeof(block_buf) && !last)
+                continue;
+
+            memset(block_buf + fill, 0, sizeof(block_buf) - fill);
+            if (mode == SdBenchMode::CONTIGUOUS)
+            {
+                while (!sdcard_log_ready())
+                    ;
+                ok = sdcard_log_write(file, block_buf);
+            }
+            else
+            {
+                ok = SD.writeBlock(first_block + written, block_buf);
+            }
+            written++;
+            fill = 0;
+        }
+        latency_add(micros() - t0);
+    }
+
+    if (mode == SdBenchMode::CONTIGUOUS)
+    {
+        while (!sdcard_log_ready())
+            ;
+        sdcard_log_close(file);
+    }
+    else
+    {
+        SD.writeStop();
+        file.close();
+    }
+    return ok;
+}
+
+bool sd_bench_run(SdBenchMode mode, uint16_t record_size, uint32_t total_bytes, SdBenchResult &result)
+{
+    memset(&result, 0, sizeof(result));
+    if (record_size == 0 || record_size > sizeof(record_buf))
+        return false;
+
+    uint32_t records = total_bytes / record_size;
+    if (mode == SdBenchMode::OPEN_WRITE_CLOSE && records > SD_BENCH_OPEN_CLOSE_RECORDS)
+        records = SD_BENCH_OPEN_CLOSE_RECORDS;
+    if (records == 0)
+        return false;
+
+    SD.remove(SD_BENCH_FILE);
+    latency_reset();
+
+    uint32_t t0 = micros();
+    bool ok = mode == SdBenchMode::CONTIGUOUS || mode == SdBenchMode::BLOCK
+                  ? run_blocks(mode, record_size, records)
+                  : run_file(mode, record_size, records);
+    result.elapsed_us = micros() - t0;
+
+    result.records = latency_seen;
+    result.bytes = latency_seen * record_size;
+    latency_summarize(result);
+    result.ok = ok && verify_file(records * record_size);
+
+    SD.remove(SD_BENCH_FILE);
+    return result.ok;
+}
+
+void sd_bench_print(SdBenchMode mode, uint16_t record_size, const SdBenchResult &result)
+{
+    float kb_per_s = result.elapsed_us ? result.bytes * 1000000.0f / 1024.0f / result.elapsed_us : 0.0f;
+
+    Serial.print("[SD] Bench ");
+    Serial.print(sd_bench_mode_name(mode));
+    Serial.print(" ");
+    Serial.print(record_size);
+    Serial.print(" B x ");
+    Serial.print(result.records);
+    Serial.print(": ");
+    Serial.print(kb_per_s, 1);
+    Serial.print(" KB/s, p50 ");
+    Serial.print(result.p50_us);
+    Serial.print(" us, p99 ");
+    Serial.print(result.p99_us);
+    Serial.print(" us, max ");
+    Serial.print(result.max_us);
+    Serial.println(result.ok ? " us, OK" : " us, FAILED");
+}
+
+bool sd_bench_all(uint16_t record_size, uint32_t total_bytes)
+{
+    bool all_ok = true;
+    for (size_t m = 0; m < (size_t)SdBenchMode::COUNT; ++m)
+    {
+        SdBenchResult result;
+        SdBenchMode mode = (SdBenchMode)m;
+        all_ok &= sd_bench_run(mode, record_size, total_bytes, result);
+        sd_bench_print(mode, record_size, result);
+    }
+    return all_ok;
+}
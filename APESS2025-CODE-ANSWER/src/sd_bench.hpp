@@ -0,0 +1,66 @@
+#pragma once
+#include <Arduino.h>
+
+/*
+ * SD write-latency benchmark
+ *
+ * Appends fixed-size records to a scratch file through each write path the
+ * firmware can use and reports throughput and per-record latency. Every
+ * record append is timed, including the card writes it triggers, so the
+ * percentiles show how long a logger writing at full speed would stall.
+ * The file is read back and checked before it is removed.
+ *
+ * Runs on the node (SD_BENCHMARK in config.hpp) and on the host against the
+ * simulated card in tools/sdsim.
+ */
+
+#define SD_BENCH_FILE "BENCH.BIN"
+#define SD_BENCH_LATENCY_SAMPLES 512 // Reservoir for the percentiles
+
+enum class SdBenchMode
+{
+    OPEN_WRITE_CLOSE, // SD.open / write / close per record, the pattern of the text logs
+    APPEND,           // File::write (SdFile::write) per record, FAT updated on close
+    APPEND_FLUSH,     // File::write + flush per record
+    CONTIGUOUS,       // sdcard_log_open / sdcard_log_write, non-blocking, as sensing does
+    BLOCK,            // Blocking SD.writeBlock of whole blocks into a pre-allocated file
+    COUNT
+};
+
+typedef struct {
+    uint32_t records;     // Records appended
+    uint32_t bytes;       // Payload bytes appended
+    uint32_t elapsed_us;  // From the first append to the file closed
+    uint32_t p50_us;      // Append latency percentiles
+    uint32_t p99_us;
+    uint32_t max_us;
+    bool ok;              // Every append succeeded and the read back matched
+} SdBenchResult;
+
+/**
+ * @brief Name of a benchmark mode, as printed in the report.
+ */
+const char *sd_bench_mode_name(SdBenchMode mode);
+
+/**
+ * @brief Run one write path over the scratch file.
+ *
+ * @param mode Write path to measure.
+ * @param record_size Bytes per append, 1 to 512.
+ * @param total_bytes Bytes to append, rounded down to whole records.
+ * @param result Receives the measurements.
+ * @return true if the run completed and the data read back intact.
+ */
+bool sd_bench_run(SdBenchMode mode, uint16_t record_size, uint32_t total_bytes, SdBenchResult &result);
+
+/**
+ * @brief Run every mode and print one report line each.
+ *
+ * @return true if all modes passed.
+ */
+bool sd_bench_all(uint16_t record_size = 64, uint32_t total_bytes = 256UL * 1024);
+
+/**
+ * @brief Print one report line for a finished run.
+ */
+void sd_bench_print(SdBenchMode mode, uint16_t record_size, const SdBenchResult &result);
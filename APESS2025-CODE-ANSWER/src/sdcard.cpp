@@ -1,6 +1,32 @@
 #include "sdcard.hpp"
+#include "crc32.hpp"
 
 static bool sd_initialized = false;
+static uint32_t sd_free_kb = UINT32_MAX; // UINT32_MAX until counted, see sdcard_count_free_kb()
+
+// Contiguous log, see sdcard_log_open()
+static uint32_t log_first_block = 0;  // Card block of file block 0
+static uint32_t log_blocks = 0;       // Pre-allocated blocks, 0 for a growing file
+static uint32_t log_written = 0;      // Blocks written so far
+static uint32_t log_crc = CRC32_INIT; // Running CRC-32 of the blocks written
+
+// Non-blocking write state: a block is either being programmed or the card is ready
+enum class LogWriteState
+{
+    READY,
+    PROGRAMMING
+};
+
+static LogWriteState log_state = LogWriteState::READY;
+static uint32_t log_issued_us = 0;    // micros() when the last block was handed to the card
+static bool log_resume = false;       // A block outside the log ended its multi-block write
+static SdcardLogStats log_stats;
+
+static uint8_t latency_bucket(uint32_t us)
+{
+    uint8_t b = us ? 32 - __builtin_clz(us) : 0;
+    return b < SDCARD_LATENCY_BUCKETS ? b : SDCARD_LATENCY_BUCKETS - 1;
+}
 
 bool sdcard_init(uint8_t cs_pin)
 {
@@ -54,3 +80,204 @@ void sdcard_test_fileio()
         Serial.println("[INIT] <SD> Failed to open file for reading.");
     }
 }
+
+bool sdcard_log_open(File &file, const char *name, uint32_t max_bytes)
+{
+    log_first_block = 0;
+    log_blocks = 0;
+    log_written = 0;
+    log_crc = CRC32_INIT;
+    log_state = LogWriteState::READY;
+    log_resume = false;
+    memset(&log_stats, 0, sizeof(log_stats));
+
+    SD.remove(name); // createContiguous() does not replace, FILE_WRITE would append
+
+    uint32_t blocks = (max_bytes + 511) / 512;
+    if (blocks > 0)
+    {
+        uint32_t last_block;
+        file = SD.createContiguous(name, blocks * 512);
+        if (file && file.contiguousRange(log_first_block, last_block))
+        {
+            log_blocks = blocks;
+
+            // One CMD25 sequence for the whole log, the card pre-erases the allocation
+            if (!SD.writeStart(log_first_block, log_blocks))
+                Serial.println("[SD] Multi-block write unavailable, writing single blocks.");
+            return true;
+        }
+
+        Serial.println("[SD] No contiguous space, using a growing file.");
+        if (file)
+        {
+            file.close();
+            SD.remove(name);
+        }
+    }
+
+    file = SD.open(name, FILE_WRITE);
+    return (bool)file;
+}
+
+bool sdcard_log_write(File &file, const uint8_t *block)
+{
+    uint32_t t0 = micros();
+
+    if (log_written < log_blocks)
+    {
+        // Reopen the multi-block write for the rest of the allocation; if that
+        // fails writeBlock() falls back to single block writes
+        if (log_resume)
+        {
+            log_resume = false;
+            SD.writeStart(log_first_block + log_written, log_blocks - log_written);
+        }
+
+        // Returns once the card accepted the data; programming overlaps with sampling
+        if (!SD.writeBlock(log_first_block + log_written, block, false))
+            return false;
+        log_state = LogWriteState::PROGRAMMING;
+    }
+    else
+    {
+        // Allocation used up: continue through the file system after the last block (blocking)
+        if (log_written == log_blocks && log_blocks > 0)
+            file.seek(log_blocks * 512);
+
+        if (file.write(block, 512) != 512)
+            return false;
+    }
+
+    log_issued_us = micros();
+    uint32_t issue_us = log_issued_us - t0;
+    log_stats.issue_hist[latency_bucket(issue_us)]++;
+    if (issue_us > log_stats.max_issue_us)
+        log_stats.max_issue_us = issue_us;
+
+    // Checksum for the catalog, computed while the card programs the block
+    log_crc = crc32_update(log_crc, block, 512);
+    log_written++;
+    log_stats.blocks++;
+    return true;
+}
+
+bool sdcard_log_ready()
+{
+    if (log_state == LogWriteState::READY)
+        return true;
+
+    if (SD.isBusy())
+    {
+        log_stats.busy_polls++;
+        return false;
+    }
+
+    uint32_t busy_us = micros() - log_issued_us;
+    log_stats.busy_hist[latency_bucket(busy_us)]++;
+    if (busy_us > log_stats.max_busy_us)
+        log_stats.max_busy_us = busy_us;
+
+    log_state = LogWriteState::READY;
+    return true;
+}
+
+uint32_t sdcard_log_blocks()
+{
+    return log_written;
+}
+
+uint32_t sdcard_log_crc()
+{
+    return crc32_final(log_crc);
+}
+
+void sdcard_log_sync(File &file)
+{
+    if (log_written > log_blocks)
+        file.flush();
+}
+
+bool sdcard_write_block(uint32_t block, const uint8_t *data, bool blocking)
+{
+    // Ends the multi-block write of the log; blocking, the data is programmed when this returns
+    if (!SD.writeBlock(block, data, blocking))
+        return false;
+
+    if (!blocking)
+    {
+        // Tracked like a log block, the next sdcard_log_write() reopens the sequence
+        log_state = LogWriteState::PROGRAMMING;
+        log_issued_us = micros();
+        log_resume = log_written < log_blocks;
+        return true;
+    }
+
+    log_state = LogWriteState::READY;
+    log_resume = false;
+    if (log_written < log_blocks)
+        SD.writeStart(log_first_block + log_written, log_blocks - log_written);
+    return true;
+}
+
+const SdcardLogStats &sdcard_log_stats()
+{
+    return log_stats;
+}
+
+static void print_histogram(const char *label, const uint32_t *hist, uint32_t max_us)
+{
+    Serial.print("[SD] ");
+    Serial.print(label);
+    Serial.print(" latency (us bucket:count):");
+    for (uint8_t b = 0; b < SDCARD_LATENCY_BUCKETS; ++b)
+    {
+        if (!hist[b])
+            continue;
+        Serial.print(b == SDCARD_LATENCY_BUCKETS - 1 ? " >=" : " <");
+        Serial.print(b == SDCARD_LATENCY_BUCKETS - 1 ? 1UL << (b - 1) : 1UL << b);
+        Serial.print(":");
+        Serial.print(hist[b]);
+    }
+    Serial.print(", max ");
+    Serial.println(max_us);
+}
+
+void sdcard_log_print_stats()
+{
+    Serial.print("[SD] Blocks written: ");
+    Serial.print(log_stats.blocks);
+    Serial.print(", busy polls: ");
+    Serial.println(log_stats.busy_polls);
+    print_histogram("Write", log_stats.issue_hist, log_stats.max_issue_us);
+    print_histogram("Busy", log_stats.busy_hist, log_stats.max_busy_us);
+}
+
+void sdcard_log_close(File &file)
+{
+    SD.writeStop(); // Waits for the last block to be programmed
+    log_state = LogWriteState::READY;
+    log_resume = false;
+    if (log_written < log_blocks)
+        file.truncate(log_written * 512);
+    file.close();
+
+    uint32_t log_kb = (log_written + 1) / 2;
+    if (sd_free_kb != UINT32_MAX)
+        sd_free_kb = sd_free_kb > log_kb ? sd_free_kb - log_kb : 0;
+
+    log_first_block = 0;
+    log_blocks = 0;
+    log_written = 0;
+}
+
+void sdcard_count_free_kb()
+{
+    if (sd_initialized)
+        sd_free_kb = SD.freeBlocks() / 2;
+}
+
+uint32_t sdcard_free_kb()
+{
+    return sd_initialized && sd_free_kb != UINT32_MAX ? sd_free_kb : 0;
+}
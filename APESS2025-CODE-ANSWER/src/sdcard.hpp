@@ -16,3 +16,103 @@ bool sdcard_init(uint8_t cs_pin = 10);
  * Writes "Hello from Arduino!" to "test.txt", then reads and prints its content.
  */
 void sdcard_test_fileio();
+
+/**
+ * @brief Create a log file pre-allocated in consecutive clusters.
+ *
+ * Blocks written with sdcard_log_write() then stream straight to the card in
+ * one pre-erased multi-block write, with no FAT or directory update while
+ * sampling. If the card has no contiguous space
+ * (or max_bytes is 0) the file is opened as a regular growing file instead.
+ *
+ * @param file Receives the open file.
+ * @param name 8.3 file name; an existing file of that name is replaced.
+ * @param max_bytes Expected size in bytes, rounded up to whole blocks.
+ * @return true if the file is open.
+ */
+bool sdcard_log_open(File &file, const char *name, uint32_t max_bytes);
+
+/**
+ * @brief Append one 512-byte block to the log opened by sdcard_log_open().
+ *
+ * Past the pre-allocated size the file grows as a regular file.
+ */
+bool sdcard_log_write(File &file, const uint8_t *block);
+
+/**
+ * @brief Truncate the log to the blocks written and close it.
+ */
+void sdcard_log_close(File &file);
+
+/**
+ * @brief Blocks of the current log handed to the card, header included.
+ */
+uint32_t sdcard_log_blocks();
+
+/**
+ * @brief CRC-32 of the blocks of the current log written so far, header included.
+ *
+ * Equals the CRC-32 of the whole file once it is closed, see catalog.hpp.
+ */
+uint32_t sdcard_log_crc();
+
+/**
+ * @brief Make the log blocks written so far survive a power loss.
+ *
+ * A growing file (or the part past the pre-allocation) syncs its directory
+ * entry and FAT, which costs several block writes; call it at bounded
+ * intervals rather than per block. A pre-allocated log has its size and
+ * clusters from sdcard_log_open() and needs nothing.
+ */
+void sdcard_log_sync(File &file);
+
+/**
+ * @brief Write one block outside the log (e.g. a journal slot).
+ *
+ * The multi-block write of an open pre-allocated log is ended for it and
+ * resumed at the next log block afterwards. Blocking, it waits for the block
+ * to be programmed; otherwise it returns once the card accepted the block and
+ * sdcard_log_ready() reports when the card can take the next log block.
+ */
+bool sdcard_write_block(uint32_t block, const uint8_t *data, bool blocking = true);
+
+/**
+ * @brief Poll the card after a log write, without waiting.
+ *
+ * sdcard_log_write() returns as soon as the card accepted the block; the
+ * card then programs it for 2-250 ms. Call this between samples and only
+ * write the next block once it returns true.
+ *
+ * @return true if the card can take the next block.
+ */
+bool sdcard_log_ready();
+
+/**
+ * @brief Count the free space on the card from the FAT.
+ *
+ * Takes seconds on a large card, so it runs once at boot after sdcard_init().
+ */
+void sdcard_count_free_kb();
+
+/**
+ * @brief Free space on the card in KiB, without touching the card.
+ *
+ * The value from sdcard_count_free_kb(), reduced by the size of each log
+ * closed with sdcard_log_close(). 0 if the card is not initialized or not
+ * counted yet.
+ */
+uint32_t sdcard_free_kb();
+
+#define SDCARD_LATENCY_BUCKETS 20 // Bucket b counts latencies in [2^(b-1), 2^b) us, the last one everything longer
+
+typedef struct {
+    uint32_t blocks;                               // Blocks written
+    uint32_t busy_polls;                           // sdcard_log_ready() calls that found the card programming
+    uint32_t issue_hist[SDCARD_LATENCY_BUCKETS];   // Time spent inside sdcard_log_write()
+    uint32_t busy_hist[SDCARD_LATENCY_BUCKETS];    // Write to first ready poll, bounded by the poll interval
+    uint32_t max_issue_us;
+    uint32_t max_busy_us;
+} SdcardLogStats;
+
+const SdcardLogStats &sdcard_log_stats();         // Reset by sdcard_log_open()
+void sdcard_log_print_stats();
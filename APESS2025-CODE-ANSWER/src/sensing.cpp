@@ -5,126 +5,662 @@
 #include "rgbled.hpp"
 #include "mpu6050.hpp"
 #include "sensing.hpp"
+#include "sample_format.hpp"
+#include "sample_ring.hpp"
+#include "sample_codec.hpp"
+#include "sample_clock.hpp"
+#include "imu_timing.hpp"
+#include "decimator.hpp"
+#include "spectrum.hpp"
+#include "trigger.hpp"
+#include "rf_cmd.hpp"
 #include "mqtt.hpp"
 #include "sdcard.hpp"
 #include "logging.hpp"
+#include "catalog.hpp"
+#include "crc32.hpp"
+#include "pacer.hpp"
 #include "wifi.hpp"
 
 static File data_file;
-static uint32_t last_sample_time = 0;
+static uint32_t next_tick = 0;        // Next tick index when polling without the hardware timer
+static bool clock_running = false;     // Ticks come from the hardware sample clock
+static bool fifo_running = false;      // Samples come from the MPU6050 FIFO, paced by the sensor clock
+static uint32_t fifo_last_drain_ms = 0;
+static uint32_t fifo_overflows = 0;
+static uint32_t next_edge = 0;         // Data-ready edge of the next FIFO record (IMU_DRDY_INTERRUPT)
+
+#define SENSING_FIFO_DRAIN_MS 10 // FIFO holds 170 samples, i.e. 170 ms at 1 kHz
+#define SENSING_PREALLOC_MAX_BYTES (1024UL * 1024 * 1024) // Larger campaigns use a growing file
+#define SENSING_CHECKPOINT_MS 5000 // Journal checkpoint interval, bounds the data a power loss can cost
 static uint32_t t_start_ms = 0;
 static uint32_t sample_count = 0;
 static char filename[32];
-static char printbuffer[64];
+static SensingProfile profile;
+static uint32_t acq_rate_hz = 0;       // IMU read rate, sensing_rate_hz times the decimation factor
+static uint32_t origin_ms = 0;         // Elapsed time of the first stored record; 0 unless triggered
+static uint32_t last_block_t0_ms = 0;  // t0_ms of the last data block handed to the card
+static uint32_t checkpoint_ms = 0;     // millis() of the last journal checkpoint
+static CatalogEntry catalog_entry;     // Header fields of the open log, completed in sensing_stop()
+#ifdef SAMPLE_COMPRESSION
+static SampleEncoder encoder;          // Coded block being filled from the ring
+static bool coded_full = false;        // The coded block is complete and waits for its write
+static uint16_t coded_next = 0;        // Next record of the oldest ring block to encode
+#endif
 
-bool sensing_prepare()
+#ifdef SENSING_TRIGGER
+static bool monitoring = false;        // Records feed the trigger, nothing is written to the card
+static bool triggered = false;
+static uint32_t trigger_elapsed_ms = 0;
+static uint64_t monitor_start_ms = 0;  // Unified time of elapsed 0 while monitoring
+static bool pre_backlog = false;       // Event records queued in the trigger ring, moved to the ring by sensing_flush()
+static uint32_t backlog_overruns = 0;  // Records dropped because that queue was full
+#endif
+
+#ifdef SAMPLE_COMPRESSION
+// Write the coded block to the card and start the next one
+static void sensing_write_coded()
+{
+    last_block_t0_ms = encoder.block.header.t0_ms;
+    if (!sdcard_log_write(data_file, reinterpret_cast<const uint8_t *>(&encoder.block)))
+    {
+        Serial.println("[SD] Block write failed.");
+    }
+    sample_encoder_reset(encoder);
+}
+
+// Write the completed coded block, or encode the oldest ring block until the coded block fills; at most
+// one card write per call, returns false if there was nothing to do
+static bool sensing_write_block()
+{
+    // Coded blocks reach the card as they fill, roughly one per three ring blocks
+    if (coded_full)
+    {
+        sensing_write_coded();
+        coded_full = false;
+        return true;
+    }
+
+    const SampleBlock *block = sample_ring_ready();
+    if (!block)
+        return false;
+
+    for (; coded_next < block->header.count; ++coded_next)
+    {
+        const SamplePoint &point = block->samples[coded_next];
+        if (!sample_encoder_push(encoder, block->header.t0_ms + point.elapsed_ms, point.ax, point.ay, point.az))
+        {
+            // The ring block is kept and resumed here once the coded block is written
+            coded_full = true;
+            return true;
+        }
+    }
+    coded_next = 0;
+    sample_ring_release();
+    return true;
+}
+#else
+// Write one full block from the ring to the card, returns false if none was ready
+static bool sensing_write_block()
+{
+    const SampleBlock *block = sample_ring_ready();
+    if (!block)
+        return false;
+
+    last_block_t0_ms = block->header.t0_ms;
+    if (!sdcard_log_write(data_file, reinterpret_cast<const uint8_t *>(block)))
+    {
+        Serial.println("[SD] Block write failed.");
+    }
+    sample_ring_release();
+    return true;
+}
+#endif
+
+// Range, anti-alias filter and sensor clock for a campaign at rate_hz
+static void sensing_setup(uint32_t rate_hz, uint8_t range_g, uint16_t dlpf_hz)
 {
     sample_count = 0;
-    t_start_ms = sensing_scheduled_start_ms;
-    last_sample_time = t_start_ms;
+    next_tick = 0;
+    origin_ms = 0;
+#ifdef SENSING_TRIGGER
+    pre_backlog = false;
+    backlog_overruns = 0;
+#endif
+
+    uint8_t decimation = 1;
+#ifdef SENSING_DECIMATION
+    decimation = decimator_factor_for(rate_hz, IMU_BASE_RATE_HZ);
+#endif
+    profile = imu_profile_for(rate_hz, range_g, dlpf_hz, decimation);
+    imu_apply_profile(profile);
+    acq_rate_hz = sensing_acquisition_rate_hz(profile);
+    decimator_reset(profile.decimation);
+#ifdef SENSING_SPECTRUM
+    spectrum_reset(rate_hz);
+#endif
+
+    char profile_buf[128];
+    snprintf(profile_buf, sizeof(profile_buf), "[SENSING] Profile: +-%d g, DLPF %d Hz, sensor %lu Hz, acquisition %lu Hz, output %d Hz (FIR %d taps)",
+             imu_range_g(profile), imu_dlpf_bandwidth_hz(profile),
+             (unsigned long)imu_sensor_rate_hz(profile), (unsigned long)acq_rate_hz,
+             profile.output_rate_hz, decimator_taps());
+    Serial.println(profile_buf);
+}
 
-    load_log_number(); // Load current log number from persistent storage
-    snprintf(filename, sizeof(filename), "N%03d_%03d.txt", NODE_ID, log_number + 1);
+// File size for duration_s at the output rate, with spare blocks for partial blocks and timing gaps
+static uint32_t sensing_file_bytes(uint32_t duration_s)
+{
+    uint64_t records = (uint64_t)profile.output_rate_hz * duration_s;
+    uint64_t blocks = 1 + (records + SAMPLE_BLOCK_CAPACITY - 1) / SAMPLE_BLOCK_CAPACITY;
+    blocks += blocks / 50 + 4;
+
+    uint64_t bytes = blocks * SAMPLE_BLOCK_SIZE;
+    return bytes > SENSING_PREALLOC_MAX_BYTES ? 0 : (uint32_t)bytes; // 0: growing file
+}
+
+// Create the next log file, sized for duration_s at the output rate
+static bool sensing_create_file(uint32_t duration_s)
+{
+    // Load current log number from persistent storage; without it the new log could replace an existing one
+    if (!load_log_number())
+    {
+        Serial.println("[SD] Log number unknown, not creating a log.");
+        return false;
+    }
+    snprintf(filename, sizeof(filename), "N%03d_%03d" SAMPLE_FILE_EXT, NODE_ID, log_number + 1);
 
     Serial.print("[SD] Opening file for streaming: ");
     Serial.println(filename);
 
-    data_file = SD.open(filename, FILE_WRITE);
-    if (!data_file)
+    // Pre-allocated so sampling never waits for cluster allocation
+    if (!sdcard_log_open(data_file, filename, sensing_file_bytes(duration_s)))
     {
         Serial.println("[SD] Failed to open file.");
         return false;
     }
+    log_active_begin(filename);
+    return true;
+}
 
-    data_file.println("=============== Sampling Metadata ===============");
-#ifdef NODE_ID
-    data_file.print("Node ID: ");
-    data_file.println(NODE_ID);
+// Write the header block of the file from sensing_create_file()
+static bool sensing_write_header(uint64_t start_ms, uint32_t duration_s, uint16_t flags, uint32_t trigger_ms)
+{
+    // === Header block: metadata and calibration, written once ===
+    uint8_t header_block[SAMPLE_BLOCK_SIZE] = {0};
+    SampleFileHeader *header = reinterpret_cast<SampleFileHeader *>(header_block);
+    header->magic = SAMPLE_FILE_MAGIC;
+    header->version = SAMPLE_FILE_VERSION;
+    header->header_size = SAMPLE_BLOCK_SIZE;
+    header->block_size = SAMPLE_BLOCK_SIZE;
+    header->record_size = sizeof(SamplePoint);
+    header->node_id = NODE_ID;
+    header->log_number = log_number + 1;
+    header->start_ms = start_ms;
+    header->rate_hz = profile.output_rate_hz;
+    header->duration_s = duration_s;
+    header->lsb_per_g = imu_lsb_per_g(profile);
+    header->cali_scale_x = cali_scale_x;
+    header->cali_scale_y = cali_scale_y;
+    header->cali_scale_z = cali_scale_z;
+    header->range_g = imu_range_g(profile);
+    header->dlpf_hz = imu_dlpf_bandwidth_hz(profile);
+    header->sensor_rate_hz = imu_sensor_rate_hz(profile);
+    header->decimation = profile.decimation;
+    header->fir_taps = decimator_taps();
+    header->flags = flags;
+    header->trigger_ms = trigger_ms;
+#ifdef SAMPLE_COMPRESSION
+    header->codec = SAMPLE_CODEC_RICE;
+#else
+    header->codec = SAMPLE_CODEC_RAW;
 #endif
 
-    // === Convert scheduled start time ===
-    CalendarTime cal = calendar_from_unix_milliseconds(sensing_scheduled_start_ms);
-    snprintf(printbuffer, sizeof(printbuffer), "%04d-%02d-%02d %02d:%02d:%02d.%03d",
-             cal.year, cal.month, cal.day, cal.hour, cal.minute, cal.second, cal.ms);
+    if (!sdcard_log_write(data_file, header_block))
+    {
+        Serial.println("[SD] Failed to write file header.");
+        sdcard_log_close(data_file);
+        log_active_end(false);
+        return false;
+    }
+
+    memset(&catalog_entry, 0, sizeof(catalog_entry));
+    catalog_entry.log_number = header->log_number;
+    catalog_entry.node_id = header->node_id;
+    catalog_entry.start_ms = header->start_ms;
+    catalog_entry.rate_hz = header->rate_hz;
+    catalog_entry.duration_s = header->duration_s;
+    catalog_entry.codec = header->codec;
+    catalog_entry.flags = header->flags;
+
+    last_block_t0_ms = 0;
+    checkpoint_ms = millis();
+    sample_ring_reset();
+#ifdef SAMPLE_COMPRESSION
+    sample_encoder_reset(encoder);
+    coded_full = false;
+    coded_next = 0;
+#endif
+    return true;
+}
 
-    data_file.print("Start Time: ");
-    data_file.println(printbuffer);
+// Create the next log file and write its header block
+static bool sensing_open_file(uint64_t start_ms, uint32_t duration_s, uint16_t flags, uint32_t trigger_ms)
+{
+    return sensing_create_file(duration_s) && sensing_write_header(start_ms, duration_s, flags, trigger_ms);
+}
 
-    data_file.print("Sampling Rate: ");
-    data_file.print(sensing_rate_hz);
-    data_file.println(" Hz");
+bool sensing_prepare()
+{
+    t_start_ms = sensing_scheduled_start_ms;
 
-    data_file.print("Duration: ");
-    data_file.print(sensing_duration_s);
-    data_file.println(" s");
+    // Range, anti-alias filter and sensor clock for this campaign
+    sensing_setup(sensing_rate_hz, sensing_range_g, sensing_dlpf_hz);
 
-    data_file.println("================= Sampling Data =================");
-    data_file.println("time_ms  , ax      , ay      , az");
+    if (!sensing_open_file(sensing_scheduled_start_ms, sensing_duration_s, 0, 0))
+        return false;
 
     Serial.println("[SENSING] Sensing started (streaming mode).");
     return true;
 }
 
+void sensing_start()
+{
+#ifdef IMU_FIFO_MODE
+#ifdef IMU_DRDY_INTERRUPT
+    if (imu_fifo_supported(profile))
+    {
+        // Edges are counted from here on; FIFO records are mapped onto them when drained
+        imu_timing_reset(micros(), Time.get_time() - t_start_ms, Time.drift_ratio, acq_rate_hz);
+        imu_drdy_begin(IMU_INT_PIN);
+        next_edge = 0;
+    }
+#endif
+
+    // The first FIFO record is taken one sample period after this call
+    if (imu_fifo_begin(profile))
+    {
+        fifo_running = true;
+        fifo_last_drain_ms = 0;
+        fifo_overflows = 0;
+        next_tick = 1;
+        Serial.println("[SENSING] Sampling paced by the IMU FIFO.");
+        return;
+    }
+    Serial.println("[SENSING] Rate not supported by the IMU FIFO, using the sample timer.");
+#endif
+
+    // Tick 0 is the scheduled start time itself
+    clock_running = sample_clock_start(acq_rate_hz, Time.drift_ratio);
+    if (!clock_running)
+    {
+        Serial.println("[SENSING] Sample timer unavailable, falling back to polling.");
+    }
+}
+
+// Buffer an output record for sensing_flush()
+static void sensing_buffer_record(uint32_t out_ms, int16_t ax, int16_t ay, int16_t az)
+{
+#ifdef SENSING_SPECTRUM
+    spectrum_push(ax, ay, az);
+#endif
+
+    // Store the raw counts in RAM only; the card is written by sensing_flush()
+    // Conversion to g uses the calibration in the file header
+    if (!sample_ring_push(out_ms - origin_ms, ax, ay, az))
+        return; // Ring full, sample dropped and counted as an overrun
+
+    // Update the number of samples taken
+    sample_count++;
+}
+
+#ifdef SENSING_TRIGGER
+// Move queued event records to the ring while it has a free block, so none is dropped
+static void sensing_feed_backlog()
+{
+    TriggerRecord record;
+    while (sample_ring_pending() < SAMPLE_RING_BLOCKS - 1 && trigger_pop(record))
+        sensing_buffer_record(record.elapsed_ms, record.ax, record.ay, record.az);
+    if (trigger_pre_count() == 0)
+        pre_backlog = false; // Later records go to the ring directly
+}
+#endif
+
+// Decimate a sample taken elapsed_ms after the scheduled start and buffer the output records
+static void sensing_store_sample(uint32_t elapsed_ms, int16_t ax, int16_t ay, int16_t az)
+{
+    // Output timestamps are the centre of the FIR window, i.e. delay compensated
+    uint32_t out_ms;
+    int16_t out[3];
+    if (!decimator_push(elapsed_ms, ax, ay, az, out_ms, out))
+        return;
+
+#ifdef SENSING_TRIGGER
+    if (monitoring)
+    {
+        // Kept in the pre-trigger ring until an event is committed
+        if (trigger_push(out_ms, out[0], out[1], out[2]) && !triggered)
+        {
+            triggered = true;
+            trigger_elapsed_ms = out_ms;
+        }
+        return;
+    }
+
+    if (pre_backlog)
+    {
+        // Behind the pre-trigger records still waiting for the ring
+        if (!trigger_append(out_ms, out[0], out[1], out[2]))
+            backlog_overruns++;
+        return;
+    }
+#endif
+
+    sensing_buffer_record(out_ms, out[0], out[1], out[2]);
+}
+
+#ifdef SENSING_SPECTRUM
+// Write the PSD / peak summary next to the sample log, e.g. N001_005.PSD
+static void sensing_write_spectrum()
+{
+    static SpectrumFileHeader header;
+    static int16_t psd_cdb[3][SPECTRUM_BINS];
+
+    memset(&header, 0, sizeof(header));
+    const float lsb_per_g = imu_lsb_per_g(profile);
+    const float scale[3] = {cali_scale_x / lsb_per_g, cali_scale_y / lsb_per_g, cali_scale_z / lsb_per_g};
+    if (!spectrum_finish(scale, header, psd_cdb))
+    {
+        Serial.println("[SENSING] Not enough samples for a spectrum.");
+        return;
+    }
+
+    header.magic = SPECTRUM_FILE_MAGIC;
+    header.version = SPECTRUM_FILE_VERSION;
+    header.header_size = sizeof(header);
+    header.node_id = NODE_ID;
+    header.log_number = log_number + 1;
+    header.start_ms = sensing_scheduled_start_ms;
+
+    char psd_filename[32];
+    snprintf(psd_filename, sizeof(psd_filename), "N%03d_%03d" SPECTRUM_FILE_EXT, NODE_ID, log_number + 1);
+    SD.remove(psd_filename); // FILE_WRITE appends
+    File psd_file = SD.open(psd_filename, FILE_WRITE);
+    if (!psd_file)
+    {
+        Serial.println("[SD] Failed to open spectrum file.");
+        return;
+    }
+
+    if (psd_file.write(reinterpret_cast<const uint8_t *>(&header), sizeof(header)) != sizeof(header) ||
+        psd_file.write(reinterpret_cast<const uint8_t *>(psd_cdb), sizeof(psd_cdb)) != sizeof(psd_cdb))
+    {
+        Serial.println("[SD] Spectrum write failed.");
+    }
+    psd_file.close();
+
+    Serial.print("[SD] Spectrum saved: ");
+    Serial.print(psd_filename);
+    Serial.print(" (");
+    Serial.print(header.segments);
+    Serial.println(" segments)");
+
+    static const char axis_name[3] = {'X', 'Y', 'Z'};
+    for (uint8_t axis = 0; axis < 3; ++axis)
+    {
+        Serial.print("[SENSING] ");
+        Serial.print(axis_name[axis]);
+        Serial.print(" peaks (Hz):");
+        for (uint8_t i = 0; i < SPECTRUM_PEAKS && header.peaks[axis][i].freq_hz > 0.0f; ++i)
+        {
+            Serial.print(" ");
+            Serial.print(header.peaks[axis][i].freq_hz, 2);
+        }
+        Serial.println();
+    }
+}
+#endif
+
+// Read the IMU for tick n and buffer the record
+static void sensing_take_sample(uint32_t tick)
+{
+    // Prepare the variables for reading IMU data
+    int16_t ax, ay, az;
+
+    // Read acceleration data from the IMU, to be completed by students, refering to mpu6050.hpp and mpu6050.cpp
+    imu_get_acceleration(ax, ay, az);
+
+    sensing_store_sample(sample_clock_tick_ms(tick, acq_rate_hz), ax, ay, az);
+}
+
+// Drain the IMU FIFO; record k of the session is sample k of the sensor clock
+static void sensing_drain_fifo()
+{
+    uint32_t now_ms = millis();
+    if (now_ms - fifo_last_drain_ms < SENSING_FIFO_DRAIN_MS)
+        return;
+    fifo_last_drain_ms = now_ms;
+
+#ifdef IMU_DRDY_INTERRUPT
+    // Refit the sensor period with the edges seen so far
+    uint32_t edges, first_edge_us;
+    uint64_t last_since_first_us;
+    imu_drdy_snapshot(edges, first_edge_us, last_since_first_us);
+    imu_timing_update(edges, first_edge_us, last_since_first_us);
+#endif
+
+    static int16_t xyz[IMU_FIFO_BURST_SAMPLES][3];
+    uint32_t first_edge;
+    int n;
+    do
+    {
+        n = imu_fifo_read(xyz, IMU_FIFO_BURST_SAMPLES, &first_edge);
+        if (n < 0)
+        {
+            // Samples were lost; realign the index with the unified clock
+            fifo_overflows++;
+            next_tick = (uint64_t)(uint32_t)(Time.get_time() - t_start_ms) * acq_rate_hz / 1000 + 1;
+            Serial.println("[SENSING] IMU FIFO overflow, samples lost.");
+            return;
+        }
+
+        if (first_edge != IMU_EDGE_UNKNOWN)
+            next_edge = first_edge;
+
+        for (int i = 0; i < n; ++i)
+        {
+            uint32_t elapsed_ms = sample_clock_tick_ms(next_tick++, acq_rate_hz);
+#ifdef IMU_DRDY_INTERRUPT
+            if (imu_timing_ready())
+                elapsed_ms = imu_timing_elapsed_ms(next_edge);
+#endif
+            next_edge++;
+            sensing_store_sample(elapsed_ms, xyz[i][0], xyz[i][1], xyz[i][2]);
+        }
+    } while (n == IMU_FIFO_BURST_SAMPLES);
+}
+
 void sensing_sample_once()
 {
-    // Check current time
-    uint32_t now_ms = Time.get_time();
+    uint32_t tick;
+
+    if (fifo_running)
+    {
+        sensing_drain_fifo();
+        return;
+    }
+
+    if (clock_running)
+    {
+        // Drain every tick the timer posted since the last visit
+        while (sample_clock_pop(tick))
+        {
+            sensing_take_sample(tick);
+        }
+        return;
+    }
 
-    // Check if we should sample
-    if (now_ms - last_sample_time >= (1000 / sensing_rate_hz))
+    // Polling fallback: same tick schedule, driven by the unified clock
+    uint32_t elapsed_ms = Time.get_time() - t_start_ms;
+    if (elapsed_ms >= sample_clock_tick_ms(next_tick, acq_rate_hz))
     {
-        // if yes, update the last sample time
-        last_sample_time += (1000 / sensing_rate_hz);
+        sensing_take_sample(next_tick++);
+    }
+}
 
-        // Prepare the variables for reading IMU data
-        int16_t ax, ay, az;
+// Record in the journal how much of the log is safely on the card; the slot
+// programs like a log block, sensing_flush() writes the next one once it is done
+static void sensing_checkpoint()
+{
+    sdcard_log_sync(data_file);
+    log_active_checkpoint(sdcard_log_blocks(), last_block_t0_ms);
+    checkpoint_ms = millis();
+}
 
-        // Read acceleration data from the IMU, to be completed by students, refering to mpu6050.hpp and mpu6050.cpp
-        imu_get_acceleration(ax, ay, az);
+void sensing_flush()
+{
+#ifdef SENSING_TRIGGER
+    if (pre_backlog)
+        sensing_feed_backlog(); // RAM only, never waits for the card
+#endif
 
-        // Calculate the elapsed time since the start of sensing
-        uint32_t elapsed = now_ms - t_start_ms;
+    // One block per call keeps the time between two samples bounded, and only
+    // once the card finished programming the previous one so sampling never waits on it
+    if (!data_file || !sdcard_log_ready())
+        return;
 
-        // Converting raw acceleration data to g's using the scaling factor and calibration factors
-        float ax_g = ax * cali_scale_x / 16384.0f;
-        float ay_g = ay * cali_scale_y / 16384.0f;
-        float az_g = az * cali_scale_z / 16384.0f;
+    // Checkpoints take a pass with no block to write, so they never hold one back
+    if (!sensing_write_block() && millis() - checkpoint_ms >= SENSING_CHECKPOINT_MS)
+        sensing_checkpoint();
+}
 
-        // print the data to the SD card file
-        char line[64];
-        snprintf(line, sizeof(line), "%8lu,%8.6f,%8.6f,%8.6f", elapsed, ax_g, ay_g, az_g);
-        data_file.println(line);
+// Stop the FIFO / sample clock and report their statistics
+static void sensing_stop_acquisition()
+{
+    if (fifo_running)
+    {
+        fifo_last_drain_ms = millis() - SENSING_FIFO_DRAIN_MS;
+        sensing_drain_fifo(); // Records still queued in the sensor
+        imu_fifo_end();
+        fifo_running = false;
 
-        // Update the number of samples taken
-        sample_count++;
+        Serial.print("[SENSING] IMU FIFO overflows: ");
+        Serial.println(fifo_overflows);
+
+#ifdef IMU_DRDY_INTERRUPT
+        imu_drdy_end(IMU_INT_PIN);
+
+        const ImuTimingStats &timing = imu_timing_stats();
+        Serial.print("[SENSING] IMU period: ");
+        Serial.print(timing.period_us, 3);
+        Serial.print(" us, batches: ");
+        Serial.print(timing.batches);
+        Serial.print(", last residual: ");
+        Serial.print(timing.last_residual_us);
+        Serial.print(" us, max residual: ");
+        Serial.print(timing.max_residual_us);
+        Serial.println(" us");
+#endif
+    }
+
+    if (clock_running)
+    {
+        sample_clock_stop();
+        clock_running = false;
+
+        Serial.print("[SENSING] Timer ticks lost: ");
+        Serial.println(sample_clock_overruns());
     }
 }
 
 void sensing_stop()
 {
+    sensing_stop_acquisition();
+
     Serial.print("[SENSING] Sampling completed. ");
     Serial.print(sample_count);
     Serial.println(" samples collected.");
 
+    const SampleRingStats &ring_stats = sample_ring_stats();
+    Serial.print("[SENSING] Buffer high-water mark: ");
+    Serial.print(ring_stats.high_water);
+    Serial.print(" / ");
+    Serial.print(SAMPLE_RING_BLOCKS);
+    Serial.print(" blocks, overruns: ");
+    Serial.println(ring_stats.overruns);
+#ifdef SENSING_TRIGGER
+    if (backlog_overruns > 0)
+    {
+        Serial.print("[SENSING] Event records dropped behind the pre-trigger ones: ");
+        Serial.println(backlog_overruns);
+    }
+#endif
+
     if (data_file)
     {
-        data_file.close();
+#ifdef SENSING_TRIGGER
+        // Event records still queued behind the pre-trigger ones
+        while (pre_backlog)
+        {
+            sensing_feed_backlog();
+            sensing_write_block();
+        }
+#endif
+        sample_ring_seal(); // Last, partially filled block
+        while (sensing_write_block())
+            ;
+#ifdef SAMPLE_COMPRESSION
+        if (encoder.block.header.count > 0)
+            sensing_write_coded();
+#endif
+        // The file is exactly the blocks written, so its size and CRC are known without reading it back
+        catalog_entry.samples = sample_count;
+        catalog_entry.bytes = sdcard_log_blocks() * SAMPLE_BLOCK_SIZE;
+        catalog_entry.file_crc = sdcard_log_crc();
+
+        sdcard_log_close(data_file);
         Serial.print("[SD] File saved: ");
         Serial.println(filename);
+        sdcard_log_print_stats();
+        catalog_append(catalog_entry);
 
-        log_number++;
-        save_log_number();
+#ifdef SENSING_SPECTRUM
+        sensing_write_spectrum();
+#endif
+
+        log_active_end(true);
     }
 
 #ifdef DATA_PRINTOUT
-    // Reopen and print file content
+    // Reopen and print file content, decoded back to g
     File f = SD.open(filename, FILE_READ);
     if (f)
     {
         Serial.println("[SD] Dumping file content:");
-        while (f.available())
+        SampleFileHeader header;
+        f.read(&header, sizeof(header));
+        f.seek(SAMPLE_BLOCK_SIZE);
+
+        char line[64];
+        SampleBlock dump;
+        while (f.read(&dump, sizeof(dump)) == sizeof(dump))
         {
-            Serial.write(f.read());
+            if (dump.header.magic != SAMPLE_BLOCK_MAGIC)
+            {
+                // Decoding a coded block needs more RAM than a debug dump is worth
+                Serial.println("[SD] Compressed log, decode it with tools/sample2csv.");
+                break;
+            }
+            for (uint16_t i = 0; i < dump.header.count; ++i)
+            {
+                const SamplePoint &point = dump.samples[i];
+                snprintf(line, sizeof(line), "%8lu,%8.6f,%8.6f,%8.6f",
+                         (unsigned long)(dump.header.t0_ms + point.elapsed_ms),
+                         point.ax * header.cali_scale_x / header.lsb_per_g,
+                         point.ay * header.cali_scale_y / header.lsb_per_g,
+                         point.az * header.cali_scale_z / header.lsb_per_g);
+                Serial.println(line);
+            }
         }
         f.close();
     }
@@ -151,70 +687,537 @@ void sensing_stop()
     sample_count = 0;
 }
 
-void sensing_retrieve_file()
+#ifdef SENSING_TRIGGER
+// Close and delete the event file of a monitoring session that recorded nothing
+static void sensing_discard_file()
 {
-    File file = SD.open(retrieval_filename, FILE_READ);
-    if (!file)
-    {
-        Serial.print("[Error] File not found: ");
-        Serial.println(retrieval_filename);
+    if (!data_file)
         return;
+    sdcard_log_close(data_file);
+    SD.remove(filename);
+    log_active_end(false);
+}
+
+void sensing_monitor_begin()
+{
+    monitor_start_ms = Time.get_time();
+    t_start_ms = monitor_start_ms;
+
+    sensing_setup(trigger_rate_hz, default_sensing_range_g, 0);
+    trigger_reset(trigger_rate_hz);
+
+    // Created before acquisition starts: the FAT scan of the pre-allocation and the journal writes
+    // would otherwise stall the trigger path longer than the IMU FIFO lasts
+    uint32_t event_s = (TRIGGER_PRE_RECORDS + trigger_rate_hz - 1) / trigger_rate_hz + trigger_post_s + 1;
+    if (!sensing_create_file(event_s))
+        Serial.println("[SENSING] Event file not created, retrying on the trigger.");
+
+    monitoring = true;
+    triggered = false;
+    sensing_start();
+
+    Serial.print("[SENSING] Monitoring for events at ");
+    Serial.print(trigger_rate_hz);
+    Serial.print(" Hz, ");
+    Serial.print(TRIGGER_PRE_RECORDS * 1000UL / trigger_rate_hz);
+    Serial.println(" ms pre-trigger.");
+}
+
+bool sensing_monitor_poll()
+{
+    sensing_sample_once();
+    return triggered;
+}
+
+void sensing_monitor_end()
+{
+    sensing_stop_acquisition();
+    sensing_discard_file();
+    monitoring = false;
+    Serial.println("[SENSING] Event monitoring stopped.");
+}
+
+// Tell the network an event log was opened
+static void sensing_announce_event(uint64_t trigger_unix_ms)
+{
+#ifdef GATEWAY
+    char buf[64];
+    snprintf(buf, sizeof(buf), "Event recorded: N%03d_%03d", NODE_ID, log_number + 1);
+    mqtt_client.publish(MQTT_TOPIC_PUB, buf);
+#endif
+#ifdef LEAFNODE
+    rf_notify_event(log_number + 1, trigger_unix_ms);
+#endif
+}
+
+bool sensing_trigger_commit(uint32_t post_s)
+{
+    monitoring = false;
+
+    // The file starts at the oldest pre-trigger record
+    uint16_t pre_count = trigger_pre_count();
+    origin_ms = pre_count ? trigger_pre_record(0).elapsed_ms : trigger_elapsed_ms;
+
+    sensing_scheduled_start_ms = monitor_start_ms + origin_ms;
+    sensing_scheduled_end_ms = monitor_start_ms + trigger_elapsed_ms + (uint64_t)post_s * 1000;
+    uint32_t duration_s = (sensing_scheduled_end_ms - sensing_scheduled_start_ms + 999) / 1000;
+
+    Serial.print("[SENSING] Event triggered, STA/LTA = ");
+    Serial.println(trigger_ratio(), 2);
+
+    // The file was created by sensing_monitor_begin(), only its header block is written here
+    if ((!data_file && !sensing_create_file(duration_s)) ||
+        !sensing_write_header(sensing_scheduled_start_ms, duration_s, SAMPLE_FLAG_TRIGGERED, trigger_elapsed_ms - origin_ms))
+    {
+        sensing_monitor_end();
+        return false;
     }
 
-    Serial.print("[Retrieval] Reading file: ");
-    Serial.println(retrieval_filename);
+    // The ring is smaller than the trigger history: pre-trigger records move to it as blocks are written by
+    // sensing_flush(), later records queue behind them
+    pre_backlog = true;
+    sensing_feed_backlog();
 
-    size_t total_size = file.size();
-    size_t bytes_sent = 0;
-    size_t chunk_size = 850;
-    size_t chunk_index = 1;
-    size_t chunk_total = (total_size + chunk_size - 1) / chunk_size;
+    // Acquisition keeps running; later records go to the file through sensing_sample_once()
+    sensing_announce_event(monitor_start_ms + trigger_elapsed_ms);
+    return true;
+}
+#endif
 
-    char prefix[32];
-    snprintf(prefix, sizeof(prefix), "%s", retrieval_filename + 1); // Remove leading '/'
-    char topic[64];
+// Whether a block read back from an interrupted log continues its time base after prev_t0_ms
+static bool sensing_block_continues(const uint8_t *block, uint32_t prev_t0_ms, uint32_t max_step_ms)
+{
+    const SampleBlockHeader *raw = reinterpret_cast<const SampleBlockHeader *>(block);
+    const SampleCodedHeader *coded = reinterpret_cast<const SampleCodedHeader *>(block);
+
+    uint32_t t0_ms;
+    if (raw->magic == SAMPLE_BLOCK_MAGIC && raw->count > 0 && raw->count <= SAMPLE_BLOCK_CAPACITY)
+        t0_ms = raw->t0_ms;
+    else if (coded->magic == SAMPLE_CODED_MAGIC && coded->count > 0 && coded->bits <= SAMPLE_CODED_PAYLOAD * 8)
+        t0_ms = coded->t0_ms;
+    else
+        return false; // Erased, never written, or torn
+
+    // Stale blocks of an older log on the same clusters rarely fit the sequence
+    return t0_ms >= prev_t0_ms && t0_ms - prev_t0_ms <= max_step_ms;
+}
+
+// Blocks of an interrupted log that hold data: those checkpointed, then those continuing them
+static uint32_t sensing_recover_blocks(File &file, const JournalRecord &record)
+{
+    SampleFileHeader header;
+    if (file.read(&header, sizeof(header)) != sizeof(header) || header.magic != SAMPLE_FILE_MAGIC || header.rate_hz == 0)
+        return 0;
+
+    // A block spans at most its capacity in records; allow twice that for timing gaps
+    uint32_t capacity = header.codec == SAMPLE_CODEC_RICE ? SAMPLE_CODED_MAX_RECORDS : SAMPLE_BLOCK_CAPACITY;
+    uint32_t max_step_ms = 2 * capacity * 1000 / header.rate_hz + 1000;
+
+    uint32_t blocks = record.checkpoint_blocks > 1 ? record.checkpoint_blocks : 1;
+    uint32_t t0_ms = record.checkpoint_t0_ms;
+    uint8_t block[SAMPLE_BLOCK_SIZE];
+
+    file.seek(blocks * SAMPLE_BLOCK_SIZE);
+    while (file.read(block, SAMPLE_BLOCK_SIZE) == SAMPLE_BLOCK_SIZE &&
+           sensing_block_continues(block, t0_ms, max_step_ms))
+    {
+        t0_ms = reinterpret_cast<const SampleBlockHeader *>(block)->t0_ms;
+        blocks++;
+    }
+    return blocks;
+}
+
+bool sensing_recover()
+{
+    JournalRecord record;
+    if (!load_log_number())
+        return false;
+    if (!log_active_pending(record))
+        return true;
+
+    Serial.print("[SD] Recovering ");
+    Serial.print(record.active_name);
+    Serial.println(" after an interrupted campaign.");
+
+    File file = SD.open(record.active_name, O_RDWR);
+    uint32_t blocks = file ? sensing_recover_blocks(file, record) : 0;
+
+    if (blocks > 1)
+    {
+        // Drop the pre-allocated tail; the directory entry then matches the data
+        file.truncate(blocks * SAMPLE_BLOCK_SIZE);
+        file.close();
 
-    while (file.available())
+        CatalogEntry entry;
+        if (catalog_scan_file(record.active_name, entry))
+            catalog_append(entry);
+        log_active_end(true);
+
+        Serial.print("[SD] Recovered ");
+        Serial.print(blocks - 1);
+        Serial.print(" data blocks (");
+        Serial.print(record.checkpoint_blocks > 1 ? blocks - record.checkpoint_blocks : blocks - 1);
+        Serial.println(" after the last checkpoint).");
+        return true;
+    }
+
+    // Nothing was sampled yet
+    if (file)
+    {
+        file.close();
+        SD.remove(record.active_name);
+    }
+    log_active_end(false);
+    Serial.println("[SD] No data to recover, log removed.");
+    return true;
+}
+
+static uint8_t retrieval_sector[SAMPLE_BLOCK_SIZE]; // Chunks pass through the card one sector at a time
+
+// CRC-32 of len bytes of the file from offset
+static bool sensing_chunk_crc(File &file, uint32_t offset, uint32_t len, uint32_t &crc)
+{
+    if (!file.seek(offset))
+        return false;
+
+    crc = CRC32_INIT;
+    for (uint32_t done = 0; done < len;)
     {
-        char buffer[851]; // chunk_size + 1 for null terminator
-        size_t len = file.readBytes(buffer, chunk_size);
-        buffer[len] = '\0';
+        uint32_t n = min(len - done, (uint32_t)sizeof(retrieval_sector));
+        if (file.read(retrieval_sector, n) != (int)n)
+            return false;
+        crc = crc32_update(crc, retrieval_sector, n);
+        done += n;
+    }
+    crc = crc32_final(crc);
+    return true;
+}
 
-        snprintf(topic, sizeof(topic), "%s[%d/%d]:", prefix, chunk_index, chunk_total);
-        String payload = String(topic) + String(buffer);
+// One MQTT message of header followed by len file bytes from offset, written to the socket as they are
+// read: beginPublish() sends the MQTT header with the total length, so the chunk is never buffered whole
+// and may exceed MQTT_MAX_PACKET_SIZE
+static bool sensing_stream_chunk(File &file, const char *header, uint32_t header_len, uint32_t offset, uint32_t len)
+{
+    if (!file.seek(offset) || !mqtt_client.beginPublish(MQTT_TOPIC_PUB, header_len + len, false))
+        return false;
 
-        bool ok = mqtt_client.publish(MQTT_TOPIC_PUB, payload.c_str());
-        if (ok)
+    bool ok = mqtt_client.write(reinterpret_cast<const uint8_t *>(header), header_len) == header_len;
+    for (uint32_t done = 0; ok && done < len;)
+    {
+        uint32_t n = min(len - done, (uint32_t)sizeof(retrieval_sector));
+        ok = file.read(retrieval_sector, n) == (int)n && mqtt_client.write(retrieval_sector, n) == n;
+        done += n;
+    }
+
+    if (!ok)
+    {
+        // Part of a message is on the wire; only a new session gets the broker back in step
+        mqtt_client.disconnect();
+        return false;
+    }
+    return mqtt_client.endPublish();
+}
+
+// Publish chunks first .. first + count - 1 (from 1) as one message, "<name>[<first>/<total>@<offset>#<crc>]:"
+// followed by their bytes, or "<name>[<first>-<last>/<total>@...]:" for several; crc is the CRC-32 of the
+// bytes, so the server can check each message and ask again for the chunks of bad ones
+static bool sensing_send_chunks(File &file, const char *prefix, uint32_t first, uint32_t count, uint32_t total, Pacer &pacer)
+{
+    uint32_t last = first + count - 1;
+    uint32_t offset = (first - 1) * RETRIEVAL_CHUNK_SIZE;
+    uint32_t len = min(file.size() - offset, count * RETRIEVAL_CHUNK_SIZE);
+
+    // The CRC goes in the header, ahead of the bytes, so the chunks are read twice; the card is much faster than WiFi
+    uint32_t crc = 0;
+    bool ok = sensing_chunk_crc(file, offset, len, crc);
+
+    char range[24];
+    if (count > 1)
+        snprintf(range, sizeof(range), "%lu-%lu", (unsigned long)first, (unsigned long)last);
+    else
+        snprintf(range, sizeof(range), "%lu", (unsigned long)first);
+
+    char header[96]; // Fits a 31 character prefix with every field at its widest
+    uint32_t header_len = snprintf(header, sizeof(header), "%s[%s/%lu@%lu#%08lX]:", prefix, range,
+                                   (unsigned long)total, (unsigned long)offset, (unsigned long)crc);
+
+    // Time to hand the message to the WiFi module: long when its buffers are backing up
+    uint32_t t0 = micros();
+    if (ok && !(ok = sensing_stream_chunk(file, header, header_len, offset, len)))
+    {
+        pacer_update(pacer, false, len, micros() - t0);
+        mqtt_loop(); // Reconnects if the broker dropped us
+        t0 = micros();
+        ok = sensing_stream_chunk(file, header, header_len, offset, len);
+    }
+    pacer_update(pacer, ok, len, micros() - t0);
+
+    if (ok)
+    {
+        Serial.print("[MQTT] Sent chunk ");
+        Serial.print(range);
+        Serial.print(" / ");
+        Serial.print(total);
+        Serial.print(" (");
+        Serial.print(offset + len);
+        Serial.print(" / ");
+        Serial.print(file.size());
+        Serial.println(" bytes)");
+    }
+    else
+    {
+        Serial.print("[Error] Failed to send chunk ");
+        Serial.println(range);
+    }
+
+    mqtt_loop(); // keep MQTT alive
+    delay(pacer.gap_ms);
+    return ok;
+}
+
+// Next "a", "a-b" or "a-" (to the end) range of a comma separated chunk list, cut to 1 .. total
+static bool sensing_next_range(const char *&range, uint32_t total, uint32_t &first, uint32_t &last)
+{
+    char *end;
+    first = strtoul(range, &end, 10);
+    if (end == range)
+        return false; // End of the list, or malformed: parse_retrieval_range() lets only digits, ',' and '-' through
+
+    last = first;
+    if (*end == '-')
+    {
+        range = end + 1;
+        last = strtoul(range, &end, 10);
+        if (end == range)
+            last = total;
+    }
+    range = *end == ',' ? end + 1 : end;
+
+    if (first < 1)
+        first = 1;
+    if (last > total)
+        last = total;
+    return true;
+}
+
+// Bytes of chunks first .. first + count - 1 in a file of size bytes
+static uint32_t sensing_chunk_bytes(uint32_t first, uint32_t count, uint32_t size)
+{
+    return min(size - (first - 1) * RETRIEVAL_CHUNK_SIZE, count * RETRIEVAL_CHUNK_SIZE);
+}
+
+#ifdef RETRIEVAL_ACK
+typedef struct {
+    uint32_t first;     // First chunk of the message, 0 if the slot is free
+    uint32_t count;
+    uint32_t sent_ms;   // millis() of the latest send
+    uint8_t sends;
+} RetrievalSlot;
+
+static RetrievalSlot retrieval_window[RETRIEVAL_WINDOW];
+static char retrieval_active[32];     // Chunk prefix of the file being sent, empty when none is
+static uint32_t retrieval_size = 0;
+static uint32_t retrieval_total = 0;  // Chunks in the file
+static uint32_t retrieval_acked = 0;  // Chunks acknowledged
+static uint32_t retrieval_acked_bytes = 0;
+static uint32_t retrieval_srtt_ms = 0; // Smoothed round trip, 0 until measured
+static uint32_t retrieval_rto_ms = RETRIEVAL_RTO_START_MS;
+
+void sensing_retrieve_ack(const char *name, const char *chunks)
+{
+    if (!retrieval_active[0] || strcmp(name, retrieval_active) != 0)
+        return; // Late ACK of an earlier retrieval
+
+    uint32_t now = millis();
+    for (RetrievalSlot &slot : retrieval_window)
+    {
+        if (!slot.first)
+            continue;
+
+        const char *range = chunks;
+        uint32_t first, last;
+        while (sensing_next_range(range, retrieval_total, first, last))
+        {
+            if (first > slot.first || last < slot.first + slot.count - 1)
+                continue;
+
+            // Round trips of resent messages are ambiguous, only the others are measured
+            if (slot.sends == 1)
+            {
+                uint32_t rtt_ms = now - slot.sent_ms;
+                retrieval_srtt_ms = retrieval_srtt_ms ? (7 * retrieval_srtt_ms + rtt_ms) / 8 : rtt_ms;
+                retrieval_rto_ms = constrain(2 * retrieval_srtt_ms, RETRIEVAL_RTO_MIN_MS, RETRIEVAL_RTO_MAX_MS);
+            }
+            retrieval_acked += slot.count;
+            retrieval_acked_bytes += sensing_chunk_bytes(slot.first, slot.count, retrieval_size);
+            slot.first = 0;
+            break;
+        }
+    }
+}
+
+static void sensing_transmit_slot(RetrievalSlot &slot, File &file, const char *prefix, Pacer &pacer)
+{
+    slot.sends++;
+    slot.sent_ms = millis();
+    sensing_send_chunks(file, prefix, slot.first, slot.count, retrieval_total, pacer); // A failed send times out
+}
+
+// Take in ACKs and resend the messages whose ACK is overdue; false once nothing is in flight
+static bool sensing_service_window(File &file, const char *prefix, Pacer &pacer)
+{
+    mqtt_loop(); // CMD_ACK arrives through mqtt_callback()
+
+    bool busy = false;
+    for (RetrievalSlot &slot : retrieval_window)
+    {
+        if (!slot.first)
+            continue;
+        if (millis() - slot.sent_ms < retrieval_rto_ms)
         {
-            bytes_sent += len;
-            Serial.print("[MQTT] Sent chunk ");
-            Serial.print(chunk_index);
-            Serial.print(" / ");
-            Serial.print(chunk_total);
-            Serial.print(" (");
-            Serial.print(bytes_sent);
-            Serial.print(" / ");
-            Serial.print(total_size);
-            Serial.println(" bytes)");
+            busy = true;
+            continue;
         }
-        else
+
+        // The message or its ACK was lost: back off, like the sender of any congested link
+        pacer_update(pacer, false, 0, 0);
+        retrieval_rto_ms = min(2 * retrieval_rto_ms, (uint32_t)RETRIEVAL_RTO_MAX_MS);
+        if (slot.sends >= RETRIEVAL_SENDS_MAX)
+        {
+            Serial.print("[Error] No ACK for chunk ");
+            Serial.println(slot.first);
+            slot.first = 0; // Left out of the [done] count, the server asks for it again
+            continue;
+        }
+        sensing_transmit_slot(slot, file, prefix, pacer);
+        busy = true;
+    }
+    return busy;
+}
+
+// Put chunks first .. first + count - 1 in flight, once a slot of the window is free
+static void sensing_send_windowed(File &file, const char *prefix, uint32_t first, uint32_t count, Pacer &pacer)
+{
+    while (true)
+    {
+        for (RetrievalSlot &slot : retrieval_window)
         {
-            Serial.print("[Error] Failed to send chunk ");
-            Serial.println(chunk_index);
+            if (slot.first)
+                continue;
+            slot.first = first;
+            slot.count = count;
+            slot.sends = 0;
+            sensing_transmit_slot(slot, file, prefix, pacer);
+            return;
         }
+        sensing_service_window(file, prefix, pacer);
+    }
+}
+#else
+void sensing_retrieve_ack(const char *, const char *)
+{
+    // Chunks are not kept in flight without RETRIEVAL_ACK
+}
+#endif
+
+void sensing_retrieve_file()
+{
+    // Copied first: a request arriving while this one is sent is served after it, see main.cpp
+    char name[sizeof(retrieval_filename)];
+    char chunks[RETRIEVAL_CHUNKS_MAX];
+    memcpy(name, retrieval_filename, sizeof(name));
+    memcpy(chunks, retrieval_chunks, sizeof(chunks));
+    node_status.node_flags.data_retrieval_requested = false;
 
-        chunk_index++;
+    char prefix[32];
+    snprintf(prefix, sizeof(prefix), "%s", name + 1); // Remove leading '/'
+
+    File file = SD.open(name, FILE_READ);
+    if (!file)
+    {
+        Serial.print("[Error] File not found: ");
+        Serial.println(name);
+
+        char missing_msg[48];
+        snprintf(missing_msg, sizeof(missing_msg), "%s[not found]", prefix);
+        mqtt_client.publish(MQTT_TOPIC_PUB, missing_msg);
+        return;
+    }
+
+    Serial.print("[Retrieval] Reading file: ");
+    Serial.print(name);
+    Serial.print(", chunks: ");
+    Serial.println(chunks[0] ? chunks : "all");
+
+    uint32_t chunk_total = (file.size() + RETRIEVAL_CHUNK_SIZE - 1) / RETRIEVAL_CHUNK_SIZE;
+    uint32_t requested = 0;
+    uint32_t sent = 0;
+    uint32_t bytes_sent = 0;
+    uint32_t start_ms = millis();
 
-        mqtt_loop(); // keep MQTT alive
-        delay(50);   // throttle
+    // Message size and spacing follow the link, see pacer.hpp
+    Pacer pacer;
+    pacer_reset(pacer);
+
+#ifdef RETRIEVAL_ACK
+    memset(retrieval_window, 0, sizeof(retrieval_window));
+    snprintf(retrieval_active, sizeof(retrieval_active), "%s", prefix);
+    retrieval_size = file.size();
+    retrieval_total = chunk_total;
+    retrieval_acked = 0;
+    retrieval_acked_bytes = 0;
+#endif
+
+    const char *range = chunks[0] ? chunks : "1-";
+    uint32_t first, last;
+    while (sensing_next_range(range, chunk_total, first, last))
+    {
+        for (uint32_t index = first; index <= last;)
+        {
+            uint32_t count = min(last - index + 1, (uint32_t)pacer.units);
+            requested += count;
+#ifdef RETRIEVAL_ACK
+            sensing_send_windowed(file, prefix, index, count, pacer);
+#else
+            if (sensing_send_chunks(file, prefix, index, count, chunk_total, pacer))
+            {
+                sent += count;
+                bytes_sent += sensing_chunk_bytes(index, count, file.size());
+            }
+#endif
+            index += count;
+        }
     }
 
+#ifdef RETRIEVAL_ACK
+    // Sent means acknowledged here
+    while (sensing_service_window(file, prefix, pacer))
+        ;
+    sent = retrieval_acked;
+    bytes_sent = retrieval_acked_bytes;
+    retrieval_active[0] = '\0';
+#endif
+
     file.close();
 
-    String done_msg = String(prefix) + "[done]";
-    mqtt_client.publish(MQTT_TOPIC_PUB, done_msg.c_str());
+    // Chunks that did not make it are asked for again with CMD_RETRIEVAL_<name>:<chunks>
+    uint32_t elapsed_ms = millis() - start_ms;
+    uint32_t throughput = elapsed_ms ? (uint64_t)bytes_sent * 1000 / elapsed_ms : 0;
+    char done_msg[80];
+    snprintf(done_msg, sizeof(done_msg), "%s[done %lu/%lu %lu B/s]", prefix,
+             (unsigned long)sent, (unsigned long)requested, (unsigned long)throughput);
+    mqtt_client.publish(MQTT_TOPIC_PUB, done_msg);
     Serial.println("[MQTT] File upload completed.");
 
-    node_status.node_flags.data_retrieval_requested = false;
+    Serial.print("[MQTT] Pacing: ");
+    Serial.print(pacer.increases);
+    Serial.print(" increases, ");
+    Serial.print(pacer.decreases);
+    Serial.print(" decreases, ended at ");
+    Serial.print(pacer.units);
+    Serial.print(" chunks / ");
+    Serial.print(pacer.gap_ms);
+    Serial.println(" ms");
+
     node_status.node_flags.data_retrieval_sent = true;
 }
@@ -5,14 +5,43 @@
 #define SENSING_PREPARING_DUR_MS 5000  // Duration for preparing sensing in milliseconds
 
 typedef struct {
-    uint16_t elapsed_ms;  // Elapsed time since sensing started (ms)
+    uint16_t elapsed_ms;  // Elapsed time since the origin of the enclosing block (ms), see sample_format.hpp
     int16_t ax;
     int16_t ay;
     int16_t az;
 } SamplePoint;
 
+/*
+ * SensingProfile - MPU6050 configuration for one sensing campaign.
+ * Chosen from the requested rate (and optional range / bandwidth) by
+ * imu_profile_for() and applied in sensing_prepare().
+ */
+typedef struct {
+    uint8_t accel_range;     // MPU6050_ACCEL_FS_* code
+    uint8_t dlpf_mode;       // MPU6050_DLPF_BW_* code, anti-alias filter
+    uint8_t rate_divider;    // SMPLRT_DIV, sensor rate = base rate / (1 + rate_divider)
+    uint8_t decimation;      // Acquisition rate / output rate, see decimator.hpp
+    uint16_t output_rate_hz; // Rate the records are stored at
+} SensingProfile;
+
+// Rate the IMU is read at, before decimation
+inline uint32_t sensing_acquisition_rate_hz(const SensingProfile &profile)
+{
+    return (uint32_t)profile.output_rate_hz * profile.decimation;
+}
+
 bool sensing_prepare();                     // Called once at the beginning of PREPARING state
+void sensing_start();                       // Called once when entering SAMPLING state, starts the sample clock
 void sensing_sample_once();                 // Called repeatedly during SAMPLING state
+void sensing_flush();                       // Called between samples during SAMPLING state, writes buffered blocks to SD
 void sensing_stop();                        // Called once at the end of SAMPLING state
 
+// Event-triggered recording (SENSING_TRIGGER), see trigger.hpp
+void sensing_monitor_begin();               // Start sampling into the pre-trigger ring while IDLE
+bool sensing_monitor_poll();                // Called repeatedly while monitoring, true once the trigger fired
+void sensing_monitor_end();                 // Stop monitoring without recording
+bool sensing_trigger_commit(uint32_t post_s); // Open the event log with the pre-trigger records, then continue as SAMPLING
+
+bool sensing_recover();                     // Called once at boot after SD init, closes a log left open by a power loss; false if the journal is unreadable
 void sensing_retrieve_file();               // Retrieve file from SD card
+void sensing_retrieve_ack(const char *name, const char *chunks); // CMD_ACK during a retrieval (RETRIEVAL_ACK)
@@ -0,0 +1,235 @@
+#include <math.h>
+#include <string.h>
+#include "spectrum.hpp"
+#include "constexpr_math.hpp"
+
+#define N SPECTRUM_FFT_SIZE
+#define HOP (SPECTRUM_FFT_SIZE / 2)
+
+static_assert((N & (N - 1)) == 0, "SPECTRUM_FFT_SIZE must be a power of two");
+
+/* === Compile-time tables === */
+
+namespace
+{
+struct SpectrumTables
+{
+    int16_t window[N];      // Hann, Q15
+    int16_t cos_tw[N / 2];  // cos(2 pi k / N), Q15
+    int16_t sin_tw[N / 2];  // sin(2 pi k / N), Q15
+    double window_power;    // sum(w^2), w in [0, 1]
+
+    constexpr SpectrumTables() : window(), cos_tw(), sin_tw(), window_power(0.0)
+    {
+        for (int i = 0; i < N; ++i)
+        {
+            double w = 0.5 - 0.5 * ce::cos(2.0 * ce::PI * i / N); // Periodic Hann, suits Welch
+            window[i] = ce::q15(w);
+            window_power += w * w;
+        }
+        for (int k = 0; k < N / 2; ++k)
+        {
+            cos_tw[k] = ce::q15(ce::cos(2.0 * ce::PI * k / N));
+            sin_tw[k] = ce::q15(ce::sin(2.0 * ce::PI * k / N));
+        }
+    }
+};
+
+constexpr SpectrumTables tables;
+} // namespace
+
+/* === State === */
+
+static int16_t segment[3][N];         // Latest N records, the second half is the next segment's first half
+static uint16_t filled = 0;
+static float accum[3][SPECTRUM_BINS]; // Sum of |X|^2 over segments, in raw counts^2
+static uint32_t segments = 0;
+static float sample_rate_hz = 0.0f;
+
+static int16_t fft_re[N];
+static int16_t fft_im[N];
+
+// In-place radix-2 FFT, halving every stage so the result is X / N
+static void spectrum_fft()
+{
+    // Bit-reversal permutation
+    for (uint16_t i = 1, j = 0; i < N; ++i)
+    {
+        uint16_t bit = N >> 1;
+        for (; j & bit; bit >>= 1)
+            j ^= bit;
+        j ^= bit;
+        if (i < j)
+        {
+            int16_t t = fft_re[i];
+            fft_re[i] = fft_re[j];
+            fft_re[j] = t;
+            t = fft_im[i];
+            fft_im[i] = fft_im[j];
+            fft_im[j] = t;
+        }
+    }
+
+    for (uint16_t len = 2; len <= N; len <<= 1)
+    {
+        uint16_t half = len >> 1;
+        uint16_t step = N / len;
+        for (uint16_t start = 0; start < N; start += len)
+        {
+            for (uint16_t k = 0; k < half; ++k)
+            {
+                // w = exp(-j 2 pi k step / N)
+                int32_t wr = tables.cos_tw[k * step];
+                int32_t wi = -tables.sin_tw[k * step];
+
+                uint16_t a = start + k;
+                uint16_t b = a + half;
+                int32_t tr = (fft_re[b] * wr - fft_im[b] * wi) >> 15;
+                int32_t ti = (fft_re[b] * wi + fft_im[b] * wr) >> 15;
+
+                int32_t ur = fft_re[a];
+                int32_t ui = fft_im[a];
+                fft_re[a] = (int16_t)((ur + tr) >> 1);
+                fft_im[a] = (int16_t)((ui + ti) >> 1);
+                fft_re[b] = (int16_t)((ur - tr) >> 1);
+                fft_im[b] = (int16_t)((ui - ti) >> 1);
+            }
+        }
+    }
+}
+
+static void spectrum_process_axis(uint8_t axis)
+{
+    const int16_t *x = segment[axis];
+
+    int32_t sum = 0;
+    for (uint16_t i = 0; i < N; ++i)
+        sum += x[i];
+    int32_t mean = sum / N;
+
+    int32_t peak = 0;
+    for (uint16_t i = 0; i < N; ++i)
+    {
+        int32_t v = x[i] - mean;
+        if (v < 0)
+            v = -v;
+        if (v > peak)
+            peak = v;
+    }
+
+    // Block floating point: use the int16 range, keep one bit of headroom
+    uint8_t shift = 0;
+    while (peak > 0 && (peak << (shift + 1)) < 16384)
+        shift++;
+
+    for (uint16_t i = 0; i < N; ++i)
+    {
+        int32_t v = (x[i] - mean) << shift;
+        if (v > 16383)
+            v = 16383;
+        if (v < -16384)
+            v = -16384;
+        fft_re[i] = (int16_t)((v * tables.window[i]) >> 15);
+        fft_im[i] = 0;
+    }
+
+    spectrum_fft();
+
+    // Undo the FFT scaling (1 / N) and the block exponent, back to raw counts
+    const float gain = (float)N / (float)(1UL << shift);
+    for (uint16_t k = 0; k < SPECTRUM_BINS; ++k)
+    {
+        float re = fft_re[k] * gain;
+        float im = fft_im[k] * gain;
+        accum[axis][k] += re * re + im * im;
+    }
+}
+
+void spectrum_reset(float rate_hz)
+{
+    memset(accum, 0, sizeof(accum));
+    filled = 0;
+    segments = 0;
+    sample_rate_hz = rate_hz;
+}
+
+void spectrum_push(int16_t ax, int16_t ay, int16_t az)
+{
+    segment[0][filled] = ax;
+    segment[1][filled] = ay;
+    segment[2][filled] = az;
+    if (++filled < N)
+        return;
+
+    for (uint8_t axis = 0; axis < 3; ++axis)
+        spectrum_process_axis(axis);
+    segments++;
+
+    // 50% overlap: the second half starts the next segment
+    for (uint8_t axis = 0; axis < 3; ++axis)
+        memmove(segment[axis], segment[axis] + HOP, HOP * sizeof(int16_t));
+    filled = HOP;
+}
+
+uint32_t spectrum_segments()
+{
+    return segments;
+}
+
+static void spectrum_find_peaks(const float *psd, float bin_hz, SpectrumPeak *peaks)
+{
+    memset(peaks, 0, SPECTRUM_PEAKS * sizeof(SpectrumPeak));
+
+    // Local maxima above the DC bins, keep the strongest ones sorted
+    for (uint16_t k = 2; k < SPECTRUM_BINS - 1; ++k)
+    {
+        if (!(psd[k] > psd[k - 1] && psd[k] >= psd[k + 1]))
+            continue;
+        if (psd[k] <= peaks[SPECTRUM_PEAKS - 1].psd)
+            continue;
+
+        // Parabolic interpolation of the peak position
+        float denom = psd[k - 1] - 2.0f * psd[k] + psd[k + 1];
+        float delta = denom != 0.0f ? 0.5f * (psd[k - 1] - psd[k + 1]) / denom : 0.0f;
+
+        SpectrumPeak peak = {(k + delta) * bin_hz, psd[k]};
+        int8_t pos = SPECTRUM_PEAKS - 1;
+        while (pos > 0 && peaks[pos - 1].psd < peak.psd)
+        {
+            peaks[pos] = peaks[pos - 1];
+            pos--;
+        }
+        peaks[pos] = peak;
+    }
+}
+
+bool spectrum_finish(const float scale[3], SpectrumFileHeader &header, int16_t psd_cdb[3][SPECTRUM_BINS])
+{
+    if (segments == 0 || sample_rate_hz <= 0.0f)
+        return false;
+
+    header.fft_size = N;
+    header.bins = SPECTRUM_BINS;
+    header.rate_hz = sample_rate_hz;
+    header.bin_hz = sample_rate_hz / N;
+    header.segments = segments;
+
+    static float psd[SPECTRUM_BINS];
+    for (uint8_t axis = 0; axis < 3; ++axis)
+    {
+        // One-sided PSD: |X|^2 / (fs * sum(w^2)), doubled except at DC and Nyquist
+        float norm = scale[axis] * scale[axis] / (segments * sample_rate_hz * (float)tables.window_power);
+        for (uint16_t k = 0; k < SPECTRUM_BINS; ++k)
+        {
+            float one_sided = (k == 0 || k == SPECTRUM_BINS - 1) ? 1.0f : 2.0f;
+            psd[k] = accum[axis][k] * norm * one_sided;
+
+            float cdb = psd[k] > 0.0f ? 1000.0f * log10f(psd[k]) : -1e9f;
+            psd_cdb[axis][k] = cdb <= -32767.0f ? SPECTRUM_DB_FLOOR
+                             : cdb >= 32767.0f  ? (int16_t)32767
+                                                : (int16_t)lroundf(cdb);
+        }
+        spectrum_find_peaks(psd, header.bin_hz, header.peaks[axis]);
+    }
+    return true;
+}
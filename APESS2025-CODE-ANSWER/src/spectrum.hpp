@@ -0,0 +1,22 @@
+#pragma once
+
+#include <stdint.h>
+#include "sample_format.hpp"
+
+/*
+ * Spectrum - streaming Welch PSD of the stored sample stream.
+ *
+ * Records are collected into SPECTRUM_FFT_SIZE-point segments with 50%
+ * overlap. Each completed segment is mean-removed, Hann windowed, scaled to
+ * use the full int16 range (block floating point) and transformed by a Q15
+ * radix-2 FFT; |X|^2 is averaged per axis. At the end of the session the
+ * average is converted to g^2/Hz and the strongest peaks are picked.
+ * Window and twiddle tables are generated at compile time.
+ */
+
+void spectrum_reset(float rate_hz);
+void spectrum_push(int16_t ax, int16_t ay, int16_t az); // Runs one FFT per axis every FFT_SIZE / 2 records
+uint32_t spectrum_segments();
+
+// Convert the average to a summary; scale[] converts raw counts of each axis to g
+bool spectrum_finish(const float scale[3], SpectrumFileHeader &header, int16_t psd_cdb[3][SPECTRUM_BINS]);
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+
+/*
+ * SpscQueue - Lock-free single-producer / single-consumer queue.
+ *
+ * One side (typically an ISR) only calls push(), the other side (loop()) only
+ * calls pop(). Each index is written by exactly one side, and the
+ * acquire/release pairs make the element visible before the index that
+ * publishes it, so no interrupt masking is needed. N must be a power of two;
+ * the queue holds up to N elements.
+ */
+template <typename T, uint32_t N>
+class SpscQueue
+{
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "SpscQueue size must be a power of two");
+
+public:
+    SpscQueue() : head(0), tail(0) {}
+
+    /* === Producer side === */
+    bool push(const T &item)
+    {
+        uint32_t h = head.load(std::memory_order_relaxed);
+        if (h - tail.load(std::memory_order_acquire) == N)
+            return false; // Full
+
+        buffer[h & (N - 1)] = item;
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    /* === Consumer side === */
+    bool pop(T &item)
+    {
+        uint32_t t = tail.load(std::memory_order_relaxed);
+        if (t == head.load(std::memory_order_acquire))
+            return false; // Empty
+
+        item = buffer[t & (N - 1)];
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Only valid while neither side is running (e.g. before the timer starts)
+    void clear()
+    {
+        head.store(0, std::memory_order_relaxed);
+        tail.store(0, std::memory_order_relaxed);
+    }
+
+    uint32_t size() const
+    {
+        return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+    }
+
+private:
+    T buffer[N];
+    std::atomic<uint32_t> head; // Next slot to write, owned by the producer
+    std::atomic<uint32_t> tail; // Next slot to read, owned by the consumer
+};
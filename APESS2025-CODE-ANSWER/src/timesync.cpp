@@ -72,16 +72,8 @@ bool rf_time_sync()
             if (node_id == NODE_ID)
                 continue;
 
-            RFMessage msg;
-            msg.from_id = NODE_ID;
-            msg.to_id = node_id;
-
             uint64_t current_time = Time.get_time();
-
-            uint32_t high = current_time >> 32;
-            uint32_t low = current_time & 0xFFFFFFFF;
-            snprintf(msg.payload, sizeof(msg.payload), "SYNC %lu %lu", high, low);
-            msg.timestamp_ms = current_time;
+            RFMessage msg = rf_message(node_id, RFTimeSync{current_time});
 
             rf_stop_listening();
             rf_send(node_id, msg, false);
@@ -118,13 +110,12 @@ bool rf_time_sync()
     while (received < SYNC_ROUNDS)
     {
         RFMessage msg;
+        RFTimeSync sync;
         if (rf_receive(msg, 100))
         {
-            if (strncmp(msg.payload, "SYNC", 4) == 0 && msg.to_id == NODE_ID)
+            if (msg.to_id == NODE_ID && rf_msg_decode(msg, sync))
             {
-                uint32_t high = 0, low = 0;
-                sscanf(msg.payload, "SYNC %lu %lu", &high, &low);
-                uint64_t gw_time = ((uint64_t)high << 32) | low;
+                uint64_t gw_time = sync.gateway_ms;
                 uint64_t local = millis();
 
                 gateway_time[received] = gw_time;
@@ -0,0 +1,106 @@
+#include "trigger.hpp"
+
+static TriggerRecord pre_ring[TRIGGER_PRE_RECORDS];
+static uint16_t pre_head = 0;   // Next slot to write
+static uint16_t pre_count = 0;
+
+static float baseline[3];
+static float sta = 0.0f;
+static float lta = 0.0f;
+static float sta_alpha = 0.0f;
+static float lta_alpha = 0.0f;
+static float baseline_alpha = 0.0f;
+static uint32_t warmup = 0;     // Records until the LTA has settled
+
+void trigger_reset(float rate_hz)
+{
+    pre_head = 0;
+    pre_count = 0;
+    sta = 0.0f;
+    lta = 0.0f;
+
+    sta_alpha = 1.0f / (TRIGGER_STA_S * rate_hz);
+    lta_alpha = 1.0f / (TRIGGER_LTA_S * rate_hz);
+    baseline_alpha = lta_alpha;
+    warmup = (uint32_t)(TRIGGER_LTA_S * rate_hz);
+}
+
+static void trigger_store(uint32_t elapsed_ms, int16_t ax, int16_t ay, int16_t az)
+{
+    TriggerRecord &slot = pre_ring[pre_head];
+    slot.elapsed_ms = elapsed_ms;
+    slot.ax = ax;
+    slot.ay = ay;
+    slot.az = az;
+    pre_head = (pre_head + 1) % TRIGGER_PRE_RECORDS;
+    if (pre_count < TRIGGER_PRE_RECORDS)
+        pre_count++;
+}
+
+bool trigger_push(uint32_t elapsed_ms, int16_t ax, int16_t ay, int16_t az)
+{
+    trigger_store(elapsed_ms, ax, ay, az);
+
+    const int16_t v[3] = {ax, ay, az};
+    float cf = 0.0f;
+    for (uint8_t i = 0; i < 3; ++i)
+    {
+        if (pre_count == 1)
+            baseline[i] = v[i];
+        float dev = v[i] - baseline[i];
+        cf += dev < 0 ? -dev : dev;
+        baseline[i] += baseline_alpha * dev;
+    }
+
+    if (pre_count == 1)
+    {
+        sta = lta = cf;
+        return false;
+    }
+
+    sta += sta_alpha * (cf - sta);
+    if (warmup > 0)
+    {
+        warmup--;
+        lta += lta_alpha * (cf - lta);
+        return false;
+    }
+
+    bool fired = sta > TRIGGER_MIN_STA && sta > TRIGGER_RATIO * lta;
+    if (!fired)
+        lta += lta_alpha * (cf - lta); // Frozen while triggered so the event does not raise its own threshold
+    return fired;
+}
+
+float trigger_ratio()
+{
+    return lta > 0.0f ? sta / lta : 0.0f;
+}
+
+uint16_t trigger_pre_count()
+{
+    return pre_count;
+}
+
+const TriggerRecord &trigger_pre_record(uint16_t i)
+{
+    uint16_t oldest = (pre_head + TRIGGER_PRE_RECORDS - pre_count) % TRIGGER_PRE_RECORDS;
+    return pre_ring[(oldest + i) % TRIGGER_PRE_RECORDS];
+}
+
+bool trigger_append(uint32_t elapsed_ms, int16_t ax, int16_t ay, int16_t az)
+{
+    if (pre_count == TRIGGER_PRE_RECORDS)
+        return false; // Would overwrite the oldest record still queued
+    trigger_store(elapsed_ms, ax, ay, az);
+    return true;
+}
+
+bool trigger_pop(TriggerRecord &record)
+{
+    if (pre_count == 0)
+        return false;
+    record = trigger_pre_record(0);
+    pre_count--;
+    return true;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <stdint.h>
+
+/*
+ * Trigger - STA/LTA event detector with a pre-trigger record ring.
+ *
+ * While armed in IDLE, every record is kept in a RAM ring holding the last
+ * TRIGGER_PRE_RECORDS records and fed to the detector. The characteristic
+ * function is the sum of the absolute deviations of the three axes from a
+ * slowly tracked baseline (gravity, offsets). Short- and long-term averages of
+ * it are exponential; the detector fires when STA > TRIGGER_RATIO * LTA and
+ * STA is above TRIGGER_MIN_STA, once the LTA has settled.
+ *
+ * Once an event is committed the ring becomes a queue: the pre-trigger
+ * records are popped oldest first into the event log, and records taken
+ * meanwhile are appended behind them so the log stays in order.
+ */
+
+#define TRIGGER_PRE_RECORDS 256       // Pre-trigger records kept in RAM
+#define TRIGGER_STA_S       0.5f      // Short-term average window (s)
+#define TRIGGER_LTA_S       10.0f     // Long-term average window (s)
+#define TRIGGER_RATIO       4.0f      // STA / LTA ratio that fires the trigger
+#define TRIGGER_MIN_STA     20.0f     // Absolute floor on the STA (raw counts), rejects noise-floor flicker
+
+typedef struct {
+    uint32_t elapsed_ms;  // Elapsed time since monitoring started
+    int16_t ax;
+    int16_t ay;
+    int16_t az;
+} TriggerRecord;
+
+void trigger_reset(float rate_hz);
+bool trigger_push(uint32_t elapsed_ms, int16_t ax, int16_t ay, int16_t az); // True on the record that fires
+
+float trigger_ratio();         // Current STA / LTA
+uint16_t trigger_pre_count();  // Records in the pre-trigger ring
+const TriggerRecord &trigger_pre_record(uint16_t i); // 0 = oldest
+
+// After a commit
+bool trigger_append(uint32_t elapsed_ms, int16_t ax, int16_t ay, int16_t az); // Queue behind the pre-trigger records, false if full
+bool trigger_pop(TriggerRecord &record); // Oldest queued record, false once the queue is empty
@@ -0,0 +1,177 @@
+/*
+ * Q15 decimator against a double-precision reference convolution over the
+ * same windows. Outputs must agree within 1.5 LSB for every factor and carry
+ * the timestamp of the input at the centre of their window. The Q15 tables
+ * themselves are checked against the Hamming-windowed sinc designed in
+ * double.
+ *
+ * Run with: pio test -e native -f test_decimator
+ */
+
+#include <unity.h>
+#include <math.h>
+#include <stdlib.h>
+#include "decimator.hpp"
+
+#define INPUTS 2000
+#define TOLERANCE_LSB 1.5
+
+static int16_t input[3][INPUTS];
+static uint32_t stamps[INPUTS];
+
+// Design of decimator.cpp in double: cutoff 0.4 / factor cycles per sample, unity DC gain
+static uint16_t reference_taps(uint8_t factor, double *h)
+{
+    const uint16_t taps = DECIMATOR_TAPS_PER_FACTOR * factor + 1;
+    const double fc = 0.4 / factor;
+    const int mid = (taps - 1) / 2;
+
+    double sum = 0.0;
+    for (int i = 0; i < taps; ++i)
+    {
+        int k = i - mid;
+        double sinc = k == 0 ? 2.0 * fc : sin(2.0 * M_PI * fc * k) / (M_PI * k);
+        double window = 0.54 - 0.46 * cos(2.0 * M_PI * i / (taps - 1));
+        h[i] = sinc * window;
+        sum += h[i];
+    }
+    for (int i = 0; i < taps; ++i)
+        h[i] /= sum;
+    return taps;
+}
+
+// Acceleration-like input: a sweep of tones plus noise, near but not at full scale
+static void make_input()
+{
+    srand(12345);
+    for (uint32_t n = 0; n < INPUTS; ++n)
+    {
+        stamps[n] = n; // 1 kHz acquisition
+        for (uint8_t axis = 0; axis < 3; ++axis)
+        {
+            double t = n / 1000.0;
+            double v = 9000.0 * sin(2.0 * M_PI * (3.0 + 40.0 * axis) * t) +
+                       6000.0 * sin(2.0 * M_PI * (90.0 + 50.0 * axis) * t * t) +
+                       (rand() % 4001 - 2000);
+            input[axis][n] = (int16_t)lround(v);
+        }
+    }
+}
+
+static void check_factor(uint8_t factor)
+{
+    // Reference filter: the Q15 taps in double, so only the fixed-point arithmetic differs
+    uint16_t taps;
+    const int16_t *q15 = decimator_coefficients(factor, taps);
+    TEST_ASSERT_NOT_NULL(q15);
+    double h[DECIMATOR_MAX_TAPS];
+    for (uint16_t i = 0; i < taps; ++i)
+        h[i] = q15[i] / 32768.0;
+    uint16_t delay = (taps - 1) / 2;
+
+    decimator_reset(factor);
+    TEST_ASSERT_EQUAL_UINT8(factor, decimator_factor());
+    TEST_ASSERT_EQUAL_UINT16(taps, decimator_taps());
+
+    uint32_t outputs = 0;
+    double max_error = 0.0;
+    for (uint32_t n = 0; n < INPUTS; ++n)
+    {
+        uint32_t out_ms;
+        int16_t out[3];
+        if (!decimator_push(stamps[n], input[0][n], input[1][n], input[2][n], out_ms, out))
+            continue;
+
+        // The window ends at input n and is centred on input n - delay
+        TEST_ASSERT_TRUE(n + 1 >= taps);
+        TEST_ASSERT_EQUAL_UINT32(0, (n - delay) % factor);
+        TEST_ASSERT_EQUAL_UINT32(stamps[n - delay], out_ms);
+
+        for (uint8_t axis = 0; axis < 3; ++axis)
+        {
+            double expected = 0.0;
+            for (uint16_t i = 0; i < taps; ++i)
+                expected += h[i] * input[axis][n + 1 - taps + i];
+            double error = fabs(out[axis] - expected);
+            if (error > max_error)
+                max_error = error;
+        }
+        outputs++;
+    }
+
+    // One output per factor inputs once the window is full
+    TEST_ASSERT_EQUAL_UINT32((INPUTS - taps) / factor + 1, outputs);
+
+    char message[48];
+    snprintf(message, sizeof(message), "factor %u: max error %.3f LSB", factor, max_error);
+    TEST_ASSERT_TRUE_MESSAGE(max_error <= TOLERANCE_LSB, message);
+    TEST_MESSAGE(message);
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_factor_2() { check_factor(2); }
+void test_factor_4() { check_factor(4); }
+void test_factor_5() { check_factor(5); }
+void test_factor_10() { check_factor(10); }
+
+void test_coefficients_match_design()
+{
+    const uint8_t factors[] = {2, 4, 5, 10};
+    for (uint8_t f : factors)
+    {
+        uint16_t taps;
+        const int16_t *h = decimator_coefficients(f, taps);
+        TEST_ASSERT_NOT_NULL(h);
+
+        double design[DECIMATOR_MAX_TAPS];
+        TEST_ASSERT_EQUAL_UINT16(reference_taps(f, design), taps);
+        uint16_t mid = (taps - 1) / 2;
+        for (uint16_t i = 0; i < taps; ++i)
+        {
+            // Rounded to Q15; the centre tap also absorbs the rounding of the others
+            double error = fabs(h[i] - design[i] * 32768.0);
+            TEST_ASSERT_TRUE(error <= (i == mid ? 0.5 * taps : 0.5 + 1e-9));
+        }
+
+        int32_t sum = 0;
+        for (uint16_t i = 0; i < taps; ++i)
+            sum += h[i];
+        TEST_ASSERT_EQUAL_INT32(32768, sum);
+        for (uint16_t i = 0; i < taps / 2; ++i)
+            TEST_ASSERT_EQUAL_INT16(h[i], h[taps - 1 - i]); // Linear phase
+    }
+}
+
+void test_pass_through_and_factor_choice()
+{
+    decimator_reset(3); // Unsupported: falls back to pass-through
+    TEST_ASSERT_EQUAL_UINT8(1, decimator_factor());
+
+    uint32_t out_ms;
+    int16_t out[3];
+    TEST_ASSERT_TRUE(decimator_push(42, 1, -2, 3, out_ms, out));
+    TEST_ASSERT_EQUAL_UINT32(42, out_ms);
+    TEST_ASSERT_EQUAL_INT16(-2, out[1]);
+
+    TEST_ASSERT_EQUAL_UINT8(10, decimator_factor_for(100, 1000));
+    TEST_ASSERT_EQUAL_UINT8(5, decimator_factor_for(200, 1000));
+    TEST_ASSERT_EQUAL_UINT8(4, decimator_factor_for(250, 1000));
+    TEST_ASSERT_EQUAL_UINT8(2, decimator_factor_for(400, 1000));
+    TEST_ASSERT_EQUAL_UINT8(1, decimator_factor_for(1000, 1000));
+}
+
+int main(int argc, char **argv)
+{
+    make_input();
+
+    UNITY_BEGIN();
+    RUN_TEST(test_factor_2);
+    RUN_TEST(test_factor_4);
+    RUN_TEST(test_factor_5);
+    RUN_TEST(test_factor_10);
+    RUN_TEST(test_coefficients_match_design);
+    RUN_TEST(test_pass_through_and_factor_choice);
+    return UNITY_END();
+}
@@ -0,0 +1,156 @@
+/*
+ * Sample clock on the simulated backend: tick spacing at rates whose period
+ * is not a whole number of milliseconds, and the tick queue between the
+ * timer (producer) and loop() (consumer).
+ *
+ * Run with: pio test -e native -f test_sample_clock
+ */
+
+#include <unity.h>
+#include "sample_clock.hpp"
+
+static uint32_t drain(uint32_t *ticks, uint32_t max)
+{
+    uint32_t count = 0;
+    uint32_t tick;
+    while (sample_clock_pop(tick))
+    {
+        if (count < max)
+            ticks[count] = tick;
+        count++;
+    }
+    return count;
+}
+
+void setUp() {}
+
+void tearDown()
+{
+    sample_clock_stop();
+}
+
+void test_tick_zero_is_immediate()
+{
+    uint32_t tick;
+    TEST_ASSERT_TRUE(sample_clock_start(400, 1.0f));
+    TEST_ASSERT_TRUE(sample_clock_pop(tick));
+    TEST_ASSERT_EQUAL_UINT32(0, tick);
+    TEST_ASSERT_FALSE(sample_clock_pop(tick));
+
+    // Tick 1 is due at 2500 us, not before
+    sample_clock_sim_advance_us(2499);
+    TEST_ASSERT_FALSE(sample_clock_pop(tick));
+    sample_clock_sim_advance_us(1);
+    TEST_ASSERT_TRUE(sample_clock_pop(tick));
+    TEST_ASSERT_EQUAL_UINT32(1, tick);
+}
+
+void test_300hz_spacing()
+{
+    static uint32_t ticks[400];
+    TEST_ASSERT_TRUE(sample_clock_start(300, 1.0f));
+
+    // Popped as it goes, like loop() does; ticks 0..299 fall within 999 ms
+    uint32_t count = 0;
+    for (uint32_t ms = 0; ms < 999; ++ms)
+    {
+        sample_clock_sim_advance_us(1000);
+        count += drain(ticks + count, 400 - count);
+    }
+    TEST_ASSERT_EQUAL_UINT32(300, count);
+    for (uint32_t n = 0; n < count; ++n)
+        TEST_ASSERT_EQUAL_UINT32(n, ticks[n]);
+    TEST_ASSERT_EQUAL_UINT32(0, sample_clock_overruns());
+
+    // 3.333 ms period: an integer-ms timer would drift to 3 ms steps, these stay on the exact grid
+    TEST_ASSERT_EQUAL_UINT32(3, sample_clock_tick_ms(1, 300));
+    TEST_ASSERT_EQUAL_UINT32(6, sample_clock_tick_ms(2, 300));
+    TEST_ASSERT_EQUAL_UINT32(10, sample_clock_tick_ms(3, 300));
+    TEST_ASSERT_EQUAL_UINT32(996, sample_clock_tick_ms(299, 300));
+    TEST_ASSERT_EQUAL_UINT32(1000, sample_clock_tick_ms(300, 300));
+}
+
+void test_400hz_spacing()
+{
+    static uint32_t ticks[500];
+    TEST_ASSERT_TRUE(sample_clock_start(400, 1.0f));
+
+    uint32_t count = 0;
+    for (uint32_t step = 0; step < 100; ++step)
+    {
+        sample_clock_sim_advance_us(10000); // 4 ticks per step
+        count += drain(ticks + count, 500 - count);
+    }
+    TEST_ASSERT_EQUAL_UINT32(401, count);
+    for (uint32_t n = 0; n < count; ++n)
+        TEST_ASSERT_EQUAL_UINT32(n, ticks[n]);
+
+    TEST_ASSERT_EQUAL_UINT32(2, sample_clock_tick_ms(1, 400));
+    TEST_ASSERT_EQUAL_UINT32(5, sample_clock_tick_ms(2, 400));
+    TEST_ASSERT_EQUAL_UINT32(7, sample_clock_tick_ms(3, 400));
+    TEST_ASSERT_EQUAL_UINT32(1000, sample_clock_tick_ms(400, 400));
+}
+
+void test_drift_ratio_shortens_local_period()
+{
+    // Local crystal 1 % slow: 1000 ticks per unified second need 990.1 us local periods
+    TEST_ASSERT_TRUE(sample_clock_start(1000, 1.01f));
+    uint32_t tick;
+    sample_clock_sim_advance_us(49505); // Tick 50 at 49504.95 us
+    static uint32_t ticks[SAMPLE_CLOCK_QUEUE_LEN];
+    TEST_ASSERT_EQUAL_UINT32(51, drain(ticks, SAMPLE_CLOCK_QUEUE_LEN));
+    TEST_ASSERT_EQUAL_UINT32(50, ticks[50]);
+    sample_clock_sim_advance_us(990); // Tick 51 at 50495.0 us
+    TEST_ASSERT_FALSE(sample_clock_pop(tick));
+    sample_clock_sim_advance_us(1);
+    TEST_ASSERT_TRUE(sample_clock_pop(tick));
+    TEST_ASSERT_EQUAL_UINT32(51, tick);
+}
+
+void test_queue_overrun()
+{
+    static uint32_t ticks[SAMPLE_CLOCK_QUEUE_LEN];
+    TEST_ASSERT_TRUE(sample_clock_start(1000, 1.0f));
+
+    // loop() stalls for 100 ms: ticks 0..100 are posted, the queue keeps the oldest ones
+    sample_clock_sim_advance_us(100000);
+    TEST_ASSERT_EQUAL_UINT32(101 - SAMPLE_CLOCK_QUEUE_LEN, sample_clock_overruns());
+    TEST_ASSERT_EQUAL_UINT32(SAMPLE_CLOCK_QUEUE_LEN, drain(ticks, SAMPLE_CLOCK_QUEUE_LEN));
+    for (uint32_t n = 0; n < SAMPLE_CLOCK_QUEUE_LEN; ++n)
+        TEST_ASSERT_EQUAL_UINT32(n, ticks[n]);
+
+    // Tick indices keep counting through the loss, timestamps stay on the grid
+    uint32_t tick;
+    sample_clock_sim_advance_us(1000);
+    TEST_ASSERT_TRUE(sample_clock_pop(tick));
+    TEST_ASSERT_EQUAL_UINT32(101, tick);
+
+    // A restart clears the queue and the counters
+    TEST_ASSERT_TRUE(sample_clock_start(1000, 1.0f));
+    TEST_ASSERT_EQUAL_UINT32(0, sample_clock_overruns());
+    TEST_ASSERT_TRUE(sample_clock_pop(tick));
+    TEST_ASSERT_EQUAL_UINT32(0, tick);
+}
+
+void test_stopped_clock_posts_nothing()
+{
+    uint32_t tick;
+    TEST_ASSERT_FALSE(sample_clock_start(0, 1.0f));
+    TEST_ASSERT_TRUE(sample_clock_start(500, 1.0f));
+    TEST_ASSERT_TRUE(sample_clock_pop(tick));
+    sample_clock_stop();
+    sample_clock_sim_advance_us(100000);
+    TEST_ASSERT_FALSE(sample_clock_pop(tick));
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_tick_zero_is_immediate);
+    RUN_TEST(test_300hz_spacing);
+    RUN_TEST(test_400hz_spacing);
+    RUN_TEST(test_drift_ratio_shortens_local_period);
+    RUN_TEST(test_queue_overrun);
+    RUN_TEST(test_stopped_clock_posts_nothing);
+    return UNITY_END();
+}
@@ -0,0 +1,87 @@
+/**
+ * @file psd2csv.cpp
+ * @brief Host-side converter from the spectrum summary (see src/sample_format.hpp) to CSV.
+ *
+ * Build and run on a PC:
+ *   g++ -O2 -I../src -o psd2csv psd2csv.cpp
+ *   ./psd2csv N001_001.PSD > N001_001_psd.csv
+ *
+ * Prints the session metadata and the peaks of each axis, then
+ * "freq_hz, psd_x, psd_y, psd_z" in g^2/Hz.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <time.h>
+#include "sample_format.hpp"
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: %s <file.PSD> [out.csv]\n", argv[0]);
+        return 1;
+    }
+
+    FILE *in = fopen(argv[1], "rb");
+    if (!in)
+    {
+        perror(argv[1]);
+        return 1;
+    }
+    FILE *out = argc > 2 ? fopen(argv[2], "w") : stdout;
+    if (!out)
+    {
+        perror(argv[2]);
+        return 1;
+    }
+
+    SpectrumFileHeader header;
+    if (fread(&header, 1, sizeof(header), in) != sizeof(header) ||
+        header.magic != SPECTRUM_FILE_MAGIC || header.bins != SPECTRUM_BINS)
+    {
+        fprintf(stderr, "%s: not a spectrum summary (or unsupported layout)\n", argv[1]);
+        return 1;
+    }
+
+    static int16_t psd_cdb[3][SPECTRUM_BINS];
+    fseek(in, header.header_size, SEEK_SET);
+    if (fread(psd_cdb, 1, sizeof(psd_cdb), in) != sizeof(psd_cdb))
+    {
+        fprintf(stderr, "%s: truncated spectrum\n", argv[1]);
+        return 1;
+    }
+
+    time_t start_s = (time_t)(header.start_ms / 1000);
+    struct tm cal;
+    gmtime_r(&start_s, &cal);
+
+    fprintf(out, "=============== Spectrum Metadata ===============\n");
+    fprintf(out, "Node ID: %u\n", header.node_id);
+    fprintf(out, "Log Number: %u\n", header.log_number);
+    fprintf(out, "Start Time: %04d-%02d-%02d %02d:%02d:%02d\n",
+            cal.tm_year + 1900, cal.tm_mon + 1, cal.tm_mday, cal.tm_hour, cal.tm_min, cal.tm_sec);
+    fprintf(out, "Sampling Rate: %.3f Hz\n", header.rate_hz);
+    fprintf(out, "FFT Size: %u, Segments: %u, Resolution: %.4f Hz\n",
+            header.fft_size, header.segments, header.bin_hz);
+
+    static const char axis_name[3] = {'X', 'Y', 'Z'};
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        fprintf(out, "Peaks %c:", axis_name[axis]);
+        for (int i = 0; i < SPECTRUM_PEAKS && header.peaks[axis][i].freq_hz > 0.0f; ++i)
+            fprintf(out, " %.3f Hz (%.3e)", header.peaks[axis][i].freq_hz, header.peaks[axis][i].psd);
+        fprintf(out, "\n");
+    }
+
+    fprintf(out, "================= Spectrum Data =================\n");
+    fprintf(out, "freq_hz  , psd_x      , psd_y      , psd_z\n");
+    for (int k = 0; k < header.bins; ++k)
+    {
+        double psd[3];
+        for (int axis = 0; axis < 3; ++axis)
+            psd[axis] = psd_cdb[axis][k] == SPECTRUM_DB_FLOOR ? 0.0 : pow(10.0, psd_cdb[axis][k] / 1000.0);
+        fprintf(out, "%9.4f,%.5e,%.5e,%.5e\n", k * header.bin_hz, psd[0], psd[1], psd[2]);
+    }
+    return 0;
+}
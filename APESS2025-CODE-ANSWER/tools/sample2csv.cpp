@@ -0,0 +1,161 @@
+/**
+ * @file sample2csv.cpp
+ * @brief Host-side converter from the binary sample log (see src/sample_format.hpp) to CSV.
+ *
+ * Build and run on a PC:
+ *   g++ -O2 -I../src -o sample2csv sample2csv.cpp ../src/sample_codec.cpp
+ *   ./sample2csv N001_001.BIN > N001_001.csv
+ *
+ * The output keeps the layout of the former text logs (metadata banner, then
+ * "time_ms, ax, ay, az" in g), so existing post-processing scripts still apply.
+ * Raw and compressed (SAMPLE_CODEC_RICE) logs are both accepted.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "sample_format.hpp"
+#include "sample_codec.hpp"
+
+static bool read_block(FILE *f, void *dst)
+{
+    return fread(dst, 1, SAMPLE_BLOCK_SIZE, f) == SAMPLE_BLOCK_SIZE;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: %s <file.BIN> [out.csv]\n", argv[0]);
+        return 1;
+    }
+
+    FILE *in = fopen(argv[1], "rb");
+    if (!in)
+    {
+        perror(argv[1]);
+        return 1;
+    }
+    FILE *out = argc > 2 ? fopen(argv[2], "w") : stdout;
+    if (!out)
+    {
+        perror(argv[2]);
+        return 1;
+    }
+
+    uint8_t raw[SAMPLE_BLOCK_SIZE];
+    if (!read_block(in, raw))
+    {
+        fprintf(stderr, "%s: truncated header\n", argv[1]);
+        return 1;
+    }
+
+    SampleFileHeader header;
+    memcpy(&header, raw, sizeof(header));
+    if (header.magic != SAMPLE_FILE_MAGIC || header.block_size != SAMPLE_BLOCK_SIZE ||
+        header.record_size != sizeof(SamplePoint))
+    {
+        fprintf(stderr, "%s: not a sample log (or unsupported layout)\n", argv[1]);
+        return 1;
+    }
+    if (header.version > SAMPLE_FILE_VERSION)
+    {
+        fprintf(stderr, "%s: file version %u is newer than this tool (%u)\n",
+                argv[1], header.version, SAMPLE_FILE_VERSION);
+        return 1;
+    }
+
+    // Skip any header padding beyond the first block
+    fseek(in, header.header_size, SEEK_SET);
+
+    time_t start_s = (time_t)(header.start_ms / 1000);
+    struct tm cal;
+    gmtime_r(&start_s, &cal);
+
+    fprintf(out, "=============== Sampling Metadata ===============\n");
+    fprintf(out, "Node ID: %u\n", header.node_id);
+    fprintf(out, "Log Number: %u\n", header.log_number);
+    fprintf(out, "Start Time: %04d-%02d-%02d %02d:%02d:%02d.%03u\n",
+            cal.tm_year + 1900, cal.tm_mon + 1, cal.tm_mday,
+            cal.tm_hour, cal.tm_min, cal.tm_sec, (unsigned)(header.start_ms % 1000));
+    fprintf(out, "Sampling Rate: %u Hz\n", header.rate_hz);
+    fprintf(out, "Duration: %u s\n", header.duration_s);
+    if (header.range_g)
+    {
+        fprintf(out, "Range: +-%u g\n", header.range_g);
+        fprintf(out, "DLPF Bandwidth: %u Hz\n", header.dlpf_hz);
+        fprintf(out, "Sensor Rate: %u Hz\n", header.sensor_rate_hz);
+    }
+    if (header.decimation > 1)
+    {
+        fprintf(out, "Decimation: %u (FIR %u taps)\n", header.decimation, header.fir_taps);
+    }
+    if (header.codec == SAMPLE_CODEC_RICE)
+    {
+        fprintf(out, "Compression: delta / Rice\n");
+    }
+    if (header.flags & SAMPLE_FLAG_TRIGGERED)
+    {
+        fprintf(out, "Triggered: at %u ms\n", header.trigger_ms);
+    }
+    fprintf(out, "================= Sampling Data =================\n");
+    fprintf(out, "time_ms  , ax      , ay      , az\n");
+
+    const float sx = header.cali_scale_x / header.lsb_per_g;
+    const float sy = header.cali_scale_y / header.lsb_per_g;
+    const float sz = header.cali_scale_z / header.lsb_per_g;
+
+    unsigned long blocks = 0, samples = 0, bad = 0;
+    static uint32_t elapsed_ms[SAMPLE_CODED_MAX_RECORDS];
+    static int16_t xyz[SAMPLE_CODED_MAX_RECORDS][3];
+    while (read_block(in, raw))
+    {
+        blocks++;
+        int count = -1;
+
+        uint16_t magic;
+        memcpy(&magic, raw, sizeof(magic));
+        if (magic == SAMPLE_BLOCK_MAGIC)
+        {
+            SampleBlock block;
+            memcpy(&block, raw, sizeof(block));
+            if (block.header.count <= SAMPLE_BLOCK_CAPACITY)
+            {
+                count = block.header.count;
+                for (int i = 0; i < count; ++i)
+                {
+                    const SamplePoint &p = block.samples[i];
+                    elapsed_ms[i] = block.header.t0_ms + p.elapsed_ms;
+                    xyz[i][0] = p.ax;
+                    xyz[i][1] = p.ay;
+                    xyz[i][2] = p.az;
+                }
+            }
+        }
+        else if (magic == SAMPLE_CODED_MAGIC)
+        {
+            SampleCodedBlock block;
+            memcpy(&block, raw, sizeof(block));
+            count = sample_decode_block(block, elapsed_ms, xyz);
+        }
+
+        if (count < 0)
+        {
+            bad++;
+            continue;
+        }
+        for (int i = 0; i < count; ++i)
+        {
+            fprintf(out, "%8lu,%8.6f,%8.6f,%8.6f\n",
+                    (unsigned long)elapsed_ms[i], xyz[i][0] * sx, xyz[i][1] * sy, xyz[i][2] * sz);
+        }
+        samples += count;
+    }
+
+    fprintf(stderr, "%s: %lu samples in %lu blocks (%lu skipped)\n", argv[1], samples, blocks, bad);
+
+    fclose(in);
+    if (out != stdout)
+        fclose(out);
+    return 0;
+}
@@ -0,0 +1,129 @@
+/**
+ * @file Arduino.h
+ * @brief Minimal Arduino core for building the SD library and logger on a PC.
+ *
+ * Only what lib/sdcard and the SD code in src/ use. Time is the simulated
+ * card clock (see sdsim.hpp): millis() and micros() advance with the SPI
+ * transfers and programming delays of the modelled card, not wall time.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+#define DEC 10
+#define HEX 16
+
+#define SS 10
+#define MOSI 11
+#define MISO 12
+#define SCK 13
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+inline void pinMode(uint8_t, uint8_t) {}
+inline void digitalWrite(uint8_t, uint8_t) {}
+inline void noInterrupts() {}
+inline void interrupts() {}
+
+class String
+{
+public:
+    String(const char *s = "") : s_(s) {}
+    const char *c_str() const { return s_.c_str(); }
+    unsigned int length() const { return s_.size(); }
+
+private:
+    std::string s_;
+};
+
+class Print
+{
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t *buf, size_t size)
+    {
+        size_t n = 0;
+        while (size--)
+            n += write(*buf++);
+        return n;
+    }
+    size_t write(const char *s) { return write((const uint8_t *)s, strlen(s)); }
+    virtual int availableForWrite() { return 0; }
+    virtual void flush() {}
+    int getWriteError() { return write_error_; }
+    void clearWriteError() { write_error_ = 0; }
+
+    size_t print(const char *s) { return write(s); }
+    size_t print(const String &s) { return write(s.c_str()); }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(unsigned char v, int base = DEC) { return print((unsigned long long)v, base); }
+    size_t print(int v, int base = DEC) { return print((long long)v, base); }
+    size_t print(unsigned int v, int base = DEC) { return print((unsigned long long)v, base); }
+    size_t print(long v, int base = DEC) { return print((long long)v, base); }
+    size_t print(unsigned long v, int base = DEC) { return print((unsigned long long)v, base); }
+    size_t print(long long v, int base = DEC)
+    {
+        return base == DEC ? format("%lld", v) : print((unsigned long long)v, base);
+    }
+    size_t print(unsigned long long v, int base = DEC)
+    {
+        return format(base == HEX ? "%llX" : "%llu", v);
+    }
+    size_t print(double v, int digits = 2) { return format("%.*f", digits, v); }
+
+    size_t println() { return write("\r\n"); }
+    template <typename T>
+    size_t println(const T &v) { return print(v) + println(); }
+    template <typename T>
+    size_t println(const T &v, int arg) { return print(v, arg) + println(); }
+
+protected:
+    void setWriteError(int err = 1) { write_error_ = err; }
+
+private:
+    int write_error_ = 0;
+
+    template <typename... Args>
+    size_t format(const char *fmt, Args... args)
+    {
+        char buf[32];
+        int n = snprintf(buf, sizeof(buf), fmt, args...);
+        return n > 0 ? write((const uint8_t *)buf, strlen(buf)) : 0;
+    }
+};
+
+class Stream : public Print
+{
+public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+};
+
+// Writes to stdout
+class HardwareSerial : public Print
+{
+public:
+    void begin(unsigned long) {}
+    operator bool() { return true; }
+    size_t write(uint8_t c) override { return fputc(c, stdout) == EOF ? 0 : 1; }
+    using Print::write;
+};
+
+extern HardwareSerial Serial;
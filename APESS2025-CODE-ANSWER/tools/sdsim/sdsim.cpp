@@ -0,0 +1,419 @@
+/**
+ * @file sdsim.cpp
+ * @brief Image-backed Sd2Card, virtual clock and Arduino runtime for host builds.
+ *
+ * Links in place of lib/sdcard/src/utility/Sd2Card.cpp, see sdsim.hpp.
+ * Multiple block writes follow Sd2Card.cpp: a non-blocking writeBlock()
+ * continues an open sequence or opens one on the second of two consecutive
+ * blocks, and any other command ends it.
+ */
+
+#include <Arduino.h>
+#include "utility/Sd2Card.h"
+#include "utility/FatStructs.h"
+#include "sdsim.hpp"
+
+#define SDSIM_POLL_US 2 // Software overhead of one busy poll besides the SPI byte
+
+HardwareSerial Serial;
+
+static FILE *image = nullptr;
+static uint32_t image_blocks = 0;
+static SdSimConfig cfg;
+static SdSimStats stats;
+static uint64_t now_us = 0;
+static uint64_t busy_until_us = 0;  // The card holds MISO low until then
+static uint32_t erased_first = 0;   // Blocks pre-erased by ACMD23 for the open sequence
+static uint32_t erased_end = 0;
+static uint32_t programmed = 0;
+static uint32_t jitter_state = 1;
+
+SdSimConfig sdsim_default_config()
+{
+    SdSimConfig c;
+    c.spi_hz = 12000000;
+    c.command_us = 20;
+    c.read_us = 300;
+    c.write_us = 1500;
+    c.stream_us = 400;
+    c.erase_us = 300;
+    c.stop_us = 1000;
+    c.stall_every = 256;
+    c.stall_us = 40000;
+    c.jitter_us = 200;
+    c.seed = 1;
+    return c;
+}
+
+bool sdsim_open(const char *path, const SdSimConfig &config)
+{
+    sdsim_close();
+    image = fopen(path, "r+b");
+    if (!image)
+        return false;
+
+    fseek(image, 0, SEEK_END);
+    image_blocks = ftell(image) / 512;
+    cfg = config;
+    jitter_state = config.seed ? config.seed : 1;
+    busy_until_us = now_us;
+    programmed = 0;
+    sdsim_reset_stats();
+    return true;
+}
+
+void sdsim_close()
+{
+    if (image)
+        fclose(image);
+    image = nullptr;
+    image_blocks = 0;
+}
+
+uint64_t sdsim_now_us()
+{
+    return now_us;
+}
+
+const SdSimStats &sdsim_stats()
+{
+    return stats;
+}
+
+void sdsim_reset_stats()
+{
+    memset(&stats, 0, sizeof(stats));
+}
+
+/* === Arduino runtime === */
+
+unsigned long millis()
+{
+    return now_us / 1000;
+}
+
+unsigned long micros()
+{
+    return now_us;
+}
+
+void delay(unsigned long ms)
+{
+    now_us += ms * 1000ULL;
+}
+
+void delayMicroseconds(unsigned int us)
+{
+    now_us += us;
+}
+
+/* === Card timing === */
+
+static void spi_transfer(uint32_t bytes)
+{
+    now_us += (uint64_t)bytes * 8 * 1000000 / cfg.spi_hz;
+}
+
+// waitNotBusy(): spin until programming finished
+static void wait_ready()
+{
+    if (now_us < busy_until_us)
+        now_us = busy_until_us;
+}
+
+static void send_command()
+{
+    wait_ready();
+    spi_transfer(6 + 2);  // Command frame, response
+    now_us += cfg.command_us;
+}
+
+static void start_programming(uint32_t base_us)
+{
+    uint32_t t = base_us;
+    if (cfg.jitter_us)
+    {
+        jitter_state = jitter_state * 1103515245UL + 12345UL;
+        t += (jitter_state >> 8) % (cfg.jitter_us + 1);
+    }
+    if (cfg.stall_every && ++programmed % cfg.stall_every == 0)
+    {
+        t += cfg.stall_us;
+        stats.stalls++;
+    }
+    busy_until_us = now_us + t;
+}
+
+static bool image_io(uint32_t block, void *buf, bool write)
+{
+    if (!image || block >= image_blocks || fseek(image, (long)block * 512, SEEK_SET))
+        return false;
+    return write ? fwrite(buf, 512, 1, image) == 1 : fread(buf, 512, 1, image) == 1;
+}
+
+/* === Sd2Card === */
+
+uint32_t Sd2Card::cardSize(void)
+{
+    return image_blocks;
+}
+
+uint8_t Sd2Card::erase(uint32_t firstBlock, uint32_t lastBlock)
+{
+    static const uint8_t zero[512] = {0};
+    if (writeStream_)
+        writeStop();
+    send_command();  // CMD32, CMD33, CMD38
+    send_command();
+    send_command();
+    for (uint32_t b = firstBlock; b <= lastBlock; ++b)
+    {
+        if (!image_io(b, (void *)zero, true))
+        {
+            error(SD_CARD_ERROR_ERASE);
+            return false;
+        }
+    }
+    start_programming(cfg.erase_us);
+    return true;
+}
+
+uint8_t Sd2Card::eraseSingleBlockEnable(void)
+{
+    return true;
+}
+
+uint8_t Sd2Card::init(uint8_t sckRateID, uint8_t chipSelectPin)
+{
+    errorCode_ = inBlock_ = partialBlockRead_ = type_ = 0;
+    writeStream_ = 0;
+    lastWrite_ = 0XFFFFFFFF;
+    chipSelectPin_ = chipSelectPin;
+    if (!image)
+    {
+        error(SD_CARD_ERROR_CMD0);
+        return false;
+    }
+    type(SD_CARD_TYPE_SDHC);
+    return setSckRate(sckRateID);
+}
+
+void Sd2Card::partialBlockRead(uint8_t value)
+{
+    partialBlockRead_ = value;
+}
+
+uint8_t Sd2Card::readBlock(uint32_t block, uint8_t* dst)
+{
+    return readData(block, 0, 512, dst);
+}
+
+uint8_t Sd2Card::readData(uint32_t block, uint16_t offset, uint16_t count, uint8_t* dst)
+{
+    uint8_t buf[512];
+    if (count == 0)
+        return true;
+    if (writeStream_)
+        writeStop();
+    if (offset + count > 512 || !image_io(block, buf, false))
+    {
+        error(SD_CARD_ERROR_CMD17);
+        return false;
+    }
+    send_command();
+    now_us += cfg.read_us;
+    spi_transfer(1 + 512 + 2);  // Start token, data, CRC
+    memcpy(dst, buf + offset, count);
+    stats.reads++;
+    return true;
+}
+
+void Sd2Card::readEnd(void)
+{
+}
+
+uint8_t Sd2Card::readRegister(uint8_t cmd, void* buf)
+{
+    (void)cmd;
+    memset(buf, 0, 16);
+    error(SD_CARD_ERROR_READ_REG);
+    return false;
+}
+
+uint8_t Sd2Card::setSckRate(uint8_t sckRateID)
+{
+    if (sckRateID > 6)
+    {
+        error(SD_CARD_ERROR_SCK_RATE);
+        return false;
+    }
+    return true;
+}
+
+uint8_t Sd2Card::setSpiClock(uint32_t clock)
+{
+    cfg.spi_hz = clock;
+    return true;
+}
+
+uint8_t Sd2Card::writeBlock(uint32_t blockNumber, const uint8_t* src, uint8_t blocking)
+{
+    if (blockNumber == 0)
+    {
+        error(SD_CARD_ERROR_WRITE_BLOCK_ZERO);
+        return false;
+    }
+    if (!blocking)
+    {
+        if (writeStream_ && blockNumber == writeNext_)
+            return writeData(src);
+        if (!writeStream_ && lastWrite_ != 0XFFFFFFFF && blockNumber == lastWrite_ + 1)
+        {
+            if (writeStart(blockNumber, 0))
+                return writeData(src);
+        }
+    }
+    lastWrite_ = blockNumber;
+
+    if (writeStream_)
+        writeStop();
+    send_command();  // CMD24
+    if (!image_io(blockNumber, (void *)src, true))
+    {
+        error(SD_CARD_ERROR_WRITE);
+        return false;
+    }
+    spi_transfer(1 + 512 + 2 + 1);  // Token, data, CRC, data response
+    start_programming(cfg.write_us + cfg.erase_us);
+    stats.single_writes++;
+
+    if (blocking)
+    {
+        wait_ready();
+        send_command();  // CMD13
+    }
+    return true;
+}
+
+uint8_t Sd2Card::writeData(const uint8_t* src)
+{
+    wait_ready();
+    if (!image_io(writeNext_, (void *)src, true))
+    {
+        error(SD_CARD_ERROR_WRITE_MULTIPLE);
+        return false;
+    }
+    spi_transfer(1 + 512 + 2 + 1);
+    bool erased = writeNext_ >= erased_first && writeNext_ < erased_end;
+    start_programming(cfg.stream_us + (erased ? 0 : cfg.erase_us));
+    stats.stream_writes++;
+    lastWrite_ = writeNext_++;
+    return true;
+}
+
+uint8_t Sd2Card::writeStart(uint32_t blockNumber, uint32_t eraseCount)
+{
+    if (blockNumber == 0)
+    {
+        error(SD_CARD_ERROR_WRITE_BLOCK_ZERO);
+        return false;
+    }
+    if (writeStream_)
+        writeStop();
+    if (eraseCount)
+    {
+        send_command();  // CMD55
+        send_command();  // ACMD23
+    }
+    erased_first = blockNumber;
+    erased_end = blockNumber + eraseCount;
+    writeNext_ = blockNumber;
+    send_command();  // CMD25
+    writeStream_ = 1;
+    stats.streams++;
+    return true;
+}
+
+uint8_t Sd2Card::writeStop(void)
+{
+    writeStream_ = 0;
+    erased_end = erased_first;
+    wait_ready();
+    spi_transfer(1);  // Stop token
+    busy_until_us = now_us + cfg.stop_us;
+    wait_ready();
+    send_command();  // CMD13
+    return true;
+}
+
+uint8_t Sd2Card::isBusy(void)
+{
+    spi_transfer(1);
+    now_us += SDSIM_POLL_US;
+    if (now_us < busy_until_us)
+    {
+        stats.busy_polls++;
+        return true;
+    }
+    return false;
+}
+
+/* === Image formatting === */
+
+#define SDSIM_ROOT_ENTRIES 512
+#define SDSIM_FAT16_MIN_CLUSTERS 4085
+#define SDSIM_FAT16_MAX_CLUSTERS 65524
+
+bool sdsim_format(const char *path, uint32_t blocks)
+{
+    // Smallest cluster that keeps the count in FAT16 range
+    uint8_t per_cluster = 1;
+    while (blocks / per_cluster > SDSIM_FAT16_MAX_CLUSTERS && per_cluster < 64)
+        per_cluster <<= 1;
+
+    uint32_t root_blocks = SDSIM_ROOT_ENTRIES * 32 / 512;
+    uint32_t fat_blocks = ((blocks / per_cluster + 2) * 2 + 511) / 512;
+    uint32_t data_start = 1 + 2 * fat_blocks + root_blocks;
+    if (blocks <= data_start)
+        return false;
+    uint32_t clusters = (blocks - data_start) / per_cluster;
+    if (clusters < SDSIM_FAT16_MIN_CLUSTERS || clusters > SDSIM_FAT16_MAX_CLUSTERS)
+        return false;
+
+    FILE *f = fopen(path, "wb");
+    if (!f)
+        return false;
+
+    uint8_t block[512] = {0};
+    fbs_t *fbs = (fbs_t *)block;
+    static_assert(sizeof(fbs_t) == 512, "Boot sector must be one block");
+    fbs->jmpToBootCode[0] = 0XEB;
+    fbs->jmpToBootCode[1] = 0X3C;
+    fbs->jmpToBootCode[2] = 0X90;
+    memcpy(fbs->oemName, "SDSIM   ", 8);
+    fbs->bpb.bytesPerSector = 512;
+    fbs->bpb.sectorsPerCluster = per_cluster;
+    fbs->bpb.reservedSectorCount = 1;
+    fbs->bpb.fatCount = 2;
+    fbs->bpb.rootDirEntryCount = SDSIM_ROOT_ENTRIES;
+    fbs->bpb.totalSectors16 = blocks < 0X10000 ? blocks : 0;
+    fbs->bpb.totalSectors32 = blocks < 0X10000 ? 0 : blocks;
+    fbs->bpb.mediaType = 0XF8;
+    fbs->bpb.sectorsPerFat16 = fat_blocks;
+    fbs->bootSectorSig0 = BOOTSIG0;
+    fbs->bootSectorSig1 = BOOTSIG1;
+    bool ok = fwrite(block, 512, 1, f) == 1;
+
+    for (uint32_t b = 1; ok && b < blocks; ++b)
+    {
+        memset(block, 0, sizeof(block));
+        // First block of each FAT: media descriptor and end of chain for the reserved clusters 0 and 1
+        if (b == 1 || b == 1 + fat_blocks)
+        {
+            block[0] = 0XF8;
+            block[1] = block[2] = block[3] = 0XFF;
+        }
+        ok = fwrite(block, 512, 1, f) == 1;
+    }
+    return fclose(f) == 0 && ok;
+}
@@ -0,0 +1,61 @@
+/**
+ * @file sdsim.hpp
+ * @brief Simulated SD card for running lib/sdcard and the logger on a PC.
+ *
+ * sdsim.cpp replaces utility/Sd2Card.cpp: the same Sd2Card class, backed by
+ * a disk image file instead of SPI. Every command, data transfer and
+ * programming phase advances a virtual clock (millis() / micros()), and
+ * while a write is programming the card reports busy, so non-blocking code
+ * paths see the same ready / busy sequence as on a real card.
+ * Single writes (CMD24), multiple block writes (CMD25, with or without the
+ * ACMD23 pre-erase) and periodic stalls are timed separately; the defaults
+ * are in the range of a class 10 microSD card on a 12 MHz SPI bus.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+typedef struct {
+    uint32_t spi_hz;      // SPI clock, sets the transfer time of commands and blocks
+    uint32_t command_us;  // Command and response overhead
+    uint32_t read_us;     // Access time of a block read
+    uint32_t write_us;    // Programming time of a single block write (CMD24)
+    uint32_t stream_us;   // Programming time of a block inside a multiple block write (CMD25)
+    uint32_t erase_us;    // Extra time for a block that was not pre-erased with ACMD23
+    uint32_t stop_us;     // Busy time after the stop token of a multiple block write
+    uint32_t stall_every; // Every Nth programmed block stalls (wear levelling, garbage collection), 0 = never
+    uint32_t stall_us;    // Extra programming time of a stall
+    uint32_t jitter_us;   // Uniform random extra programming time, 0 .. jitter_us
+    uint32_t seed;        // Jitter sequence
+} SdSimConfig;
+
+typedef struct {
+    uint32_t reads;          // Blocks read
+    uint32_t single_writes;  // CMD24 writes
+    uint32_t stream_writes;  // Blocks written inside a CMD25 sequence
+    uint32_t streams;        // CMD25 sequences opened
+    uint32_t stalls;
+    uint32_t busy_polls;     // isBusy() calls that found the card programming
+} SdSimStats;
+
+SdSimConfig sdsim_default_config();
+
+/**
+ * @brief Create an image of `blocks` 512-byte blocks holding an empty FAT16
+ *        volume without partition table, as SD.begin() mounts it.
+ *
+ * @return false if the size is outside FAT16 (about 2 MB to 2 GB) or the
+ *         file cannot be written.
+ */
+bool sdsim_format(const char *path, uint32_t blocks);
+
+/**
+ * @brief Attach an image; the next Sd2Card::init() (SD.begin()) opens it.
+ */
+bool sdsim_open(const char *path, const SdSimConfig &config);
+void sdsim_close();
+
+uint64_t sdsim_now_us();
+const SdSimStats &sdsim_stats();
+void sdsim_reset_stats();